@@ -5,23 +5,98 @@
 #include "mid_pwm.h"
 #include "mid_timer.h"
 #include "mid_adc.h"
+#include "mid_measure.h"
+#include "mid_fft.h"
 #include "hw_key.h"
 #include "hw_adc.h"
 #include "kanade_img.h"
 #include "hw_lcdinit.h"
+#include "systick.h"
 
-#define volThreshold 40								/* Trigger threshold display position */
-#define wave_width	 155							/* Waveform display width (full screen) */
+#define wave_width	 ADC_WINDOW_NUM					/* Waveform display width (full screen) */
 #define wave_height	 128							/* Waveform display height */
+#define roll_chunk	 16								/* Roll: samples fetched per read */
+#define span_merge	 5								/* Unchanged rows written through instead of a second window */
+#define span_none	 111							/* Top of an empty column span, below any bottom */
+#define wave_rows	 90								/* Rows of the wave area, 110 is the bottom */
+#define vscale_num	 4								/* Selectable vertical scales */
+#define vrefint_mv	 1200							/* Typical Vrefint of the GD32E230 */
+
+#define WAVE_STYLE_LINE  0							/* Connected line through the samples */
+#define WAVE_STYLE_SPAN  1							/* Peak-detect min/max span per column */
+#define WAVE_STYLE_ROLL  2							/* Scrolling span per column */
+
+#define FFT_Y_TOP        21							/* Spectrum row of 0dBFS */
+#define FFT_Y_BOTTOM     111						/* Spectrum baseline */
+#define FFT_RANGE        800						/* Spectrum display range, 0.1dB */
+#define FFT_PEAK_MIN     200						/* Weaker peaks are not reported, 0.1dB above the floor */
+#define FFT_VIEW_SPECTRUM 0							/* 512-point spectrum */
+#define FFT_VIEW_HARM    1							/* Goertzel harmonics of the measured frequency */
+#define FFT_VIEW_MAX     2
+#define HARM_SLOT        (wave_width / HARM_MAX)	/* Columns per harmonic bar */
+
+#define AUTOSET_NUM      256						/* Pre-capture length per autoset stage */
+#define AUTOSET_ROWS     72							/* Rows the signal should span, 80% of the wave area */
+
+#define INFO_TOP         0							/* OSC and spectrum: status row */
+#define INFO_LABEL       1							/* OSC and spectrum: bottom bar label */
+#define INFO_VALUE       2							/* OSC and spectrum: bottom bar value */
+#define INFO_FREQ        3							/* OSC: bottom bar frequency */
+#define INFO_PWM_STATE   0							/* PWM: output state */
+#define INFO_PWM_FREQ    1							/* PWM: frequency */
+#define INFO_PWM_DUTY    2							/* PWM: duty cycle */
+#define INFO_NUM         4
 
 static uint8_t current_page = PAGE_OSC;				/* Current display page */
-static uint8_t step_value = 6;						/* Waveform scan step value */
 static int16_t oldWave[wave_width];					/* Previous displayed waveform data */
 static int16_t newWave[wave_width];					/* New waveform data to display */
-static float maxVol = 0;							/* Input signal maximum voltage */
-static float minVol = 0;							/* Input signal minimum voltage */
-static uint16_t adc_value[ADC_NUM];					/* Store ADC raw data */
-static uint16_t adc_value2[ADC_NUM];				/* Store ADC raw data */
+static uint8_t oldLow[wave_width];					/* Previous peak-detect span bottom */
+static uint8_t newLow[wave_width];					/* New peak-detect span bottom, newWave is the top */
+static uint8_t wave_style = WAVE_STYLE_LINE;		/* Drawing style of the previous frame */
+static uint8_t osc_roll = 0;						/* Roll mode selected */
+static uint8_t meas_sel = MEAS_VPP;					/* Measurement shown in the bottom bar */
+static uint8_t fft_window = FFT_WIN_HANN;			/* Window applied before the transform */
+static uint16_t fft_peak_level = 0;					/* Level of the strongest bin, 0.1dB */
+static uint32_t fft_peak_chz = 0;					/* Frequency of the strongest bin, 0.01Hz */
+static uint32_t fft_sample_ns = 0;					/* Sample interval of the last transform */
+static uint8_t fft_view = FFT_VIEW_SPECTRUM;		/* Spectrum or harmonic bars */
+static struct harm_result harm_res;					/* Last harmonic analysis */
+static uint32_t harm_chz = 0;						/* Fundamental the analysis was tuned to, 0.01Hz */
+static struct tft_field info_field[INFO_NUM];		/* Text fields of the current page, placed by its static UI */
+static int16_t trig_level_y = -1;					/* Row of the drawn trigger level marker, -1 = none */
+
+/* Trigger modes in the status row, the comparator source is rising only */
+static const char * const trig_label[TRIG_MODE_MAX] =
+{
+	"RIS", "FAL", "EDG", "PW>", "PW<", "RNT"
+};
+
+static const char * const meas_label[MEAS_MAX] =
+{
+	"Vpp:", "Avg:", "RMS:", "Per:", "Dty:", "Tr :", "Tf :"
+};
+static uint16_t maxMv = 0;							/* Input signal maximum voltage, mV */
+static uint16_t minMv = 0;							/* Input signal minimum voltage, mV */
+static uint16_t meanMv = 0;							/* Input signal average voltage, mV */
+static uint16_t rmsMv = 0;							/* Input signal RMS voltage, mV */
+static uint32_t scale_px_q16 = 0;					/* Pixels per ADC count, Q16 */
+static uint32_t scale_mv_q16 = 0;					/* Millivolts per ADC count, Q16 */
+static uint16_t scale_vref = 0;						/* Vrefint reading the factors were computed for */
+static uint8_t scale_bits = 0;						/* Sample width the factors were computed for */
+static uint8_t scale_ppv = 0;						/* Vertical scale the factors were computed for */
+static uint16_t scale_base_px = 0;					/* Rows below the bottom of the wave area */
+static uint8_t osc_vscale = 0;						/* Vertical scale index */
+static uint16_t osc_base_mv = 0;					/* ADC pin voltage at the bottom row, mV */
+
+/* Vertical scales in pixels per volt at the ADC pin, shown as x1..x8 */
+static const uint8_t osc_vscale_tab[vscale_num] = {20, 40, 80, 160};
+
+/* Autoset pre-capture timebases: 1us, 10us and 100us sampling, 256us to 25.6ms per stage */
+static const uint8_t autoset_tb[] = {1, 4, 7};
+
+static int16_t osc_count_to_y(uint16_t count);
+static void osc_spanClear(void);
+static uint16_t adc_value[ADC_NUM];					/* ADC DMA ring, 16-bit or packed 8-bit samples */
 static uint8_t osc_stop_bit = OSC_RUN;				/* Oscilloscope pause flag */
 
 
@@ -30,46 +105,20 @@ static uint8_t osc_stop_bit = OSC_RUN;				/* Oscilloscope pause flag */
 */
 void Register_oscShowData(void)
 {
+	adc_capture_register(adc_value);
 	mx_adc_dma_init((uint32_t)(&adc_value), ADC_NUM);
+	set_adc_timebase_value(get_adc_timebase_value());
+	mx_adc_timer_trigger_enable();
 }
 
 /*
-*   Restart DMA for next acquisition (lightweight)
-*/
-static void Restart_oscShowData(void)
-{
-	mx_adc_dma_restart((uint32_t)(&adc_value), ADC_NUM);
-}
-
-/*
-*   Function: Clear ADC display data
+*   Function: Drop the pending half buffer, the next completed half is shown
 *   Parameters: None
 *   Return: None
 */
 void clear_adc_value(void)
 {
 	set_adc_convert_value(ADC_CONVERT_UN_FINSIH);
-	memset(adc_value, 0, ADC_NUM * sizeof(uint16_t));
-}
-
-/*
-*   Function: Set scan step value
-*   Parameters: value - Step value
-*   Return: None
-*/
-void set_step_value(uint8_t value)
-{
-	step_value = value;
-}
-
-/*
-*   Function: Get scan step value
-*   Parameters: None
-*   Return: Step value
-*/
-uint8_t get_step_value(void)
-{
-	return step_value;
 }
 
 /*
@@ -97,20 +146,28 @@ uint8_t get_current_page(void)
 	return current_page;
 }
 
-static void Restart_oscShowData(void);
-
 void switch_page(void)
 {
+	uint16_t i = 0;
+
 	current_page = (current_page + 1) % PAGE_MAX;
 	TFT_Fill(0, 0, 160, 128, BLACK);
 	switch(current_page)
 	{
 		case PAGE_OSC:
 			TFT_OscStaticUI();
-			memset(oldWave, 0, sizeof(oldWave));
+			osc_spanClear();
 			memset(newWave, 0, sizeof(newWave));
+			/* Spectrum frames reuse the ring, restart roll and span drawing from scratch */
+			wave_style = WAVE_STYLE_LINE;
 			clear_adc_value();
-			Restart_oscShowData();
+			break;
+		case PAGE_FFT:
+			TFT_FftStaticUI();
+			for(i = 0; i < wave_width; i++)
+			{
+				oldWave[i] = FFT_Y_BOTTOM;
+			}
 			break;
 		case PAGE_PWM:
 			TFT_PwmStaticUI();
@@ -148,8 +205,25 @@ void TFT_OscStaticUI(void)
     }
     /* Bottom info bar background */
     TFT_Fill(0,112,160,128,DARKBLUE);
-    TFT_ShowString(2,112,(uint8_t *)"Vpp:",WHITE,DARKBLUE,16,0);
     TFT_ShowString(80,112,(uint8_t *)"F:",WHITE,DARKBLUE,16,0);
+    TFT_ShowTrigPos();
+
+    TFT_FieldInit(&info_field[INFO_TOP],2,0,16);
+    TFT_FieldInit(&info_field[INFO_LABEL],2,112,16);
+    TFT_FieldInit(&info_field[INFO_VALUE],34,112,16);
+    TFT_FieldInit(&info_field[INFO_FREQ],96,112,16);
+    trig_level_y = -1;
+}
+
+/*
+ * Trigger position marker below the status row
+ */
+void TFT_ShowTrigPos(void)
+{
+    uint16_t pre = get_adc_trigger_pre();
+
+    TFT_Fill(1,17,wave_width,20,BLACK);
+    TFT_Fill(pre,17,pre+1,20,YELLOW);
 }
 
 /*
@@ -161,32 +235,267 @@ void TFT_StaticUI(void)
 }
 
 /*
- * Show oscilloscope bottom info (Vpp + Freq)
+ * Time in ns to a short label: 500ns, 2.5us, 10us, 1.2ms, 50ms
+ */
+static void osc_format_time(char *buf, uint32_t ns)
+{
+    const char *unit = "ns";
+    uint32_t base = 1;
+
+    if(ns >= 1000000UL)
+    {
+        base = 1000000UL;
+        unit = "ms";
+    }
+    else if(ns >= 1000UL)
+    {
+        base = 1000UL;
+        unit = "us";
+    }
+
+    /* One decimal below 10 units when it is not zero */
+    if((base > 1) && (ns < base * 10U) && (((ns % base) / (base / 10U)) != 0))
+        sprintf(buf,"%d.%d%s",(uint16_t)(ns / base),(uint16_t)((ns % base) / (base / 10U)),unit);
+    else
+        sprintf(buf,"%d%s",(uint16_t)(ns / base),unit);
+}
+
+/*
+ * Interval between two display columns in ns
+ */
+static uint32_t osc_sample_ns(void)
+{
+    /* Equivalent-time columns are ADC_ETS_FACTOR times closer than the real samples */
+    if(get_adc_acq_mode() == ADC_ACQ_ETS)
+        return get_adc_timebase_info()->sample_ns / ADC_ETS_FACTOR;
+    return get_adc_timebase_info()->sample_ns;
+}
+
+/*
+ * Selected measurement value, voltages are at the probe (front end divides the input by 2)
+ */
+static void osc_format_measure(char *buf)
+{
+    const struct measure_result *res = get_measure_result();
+    uint16_t mv = 0;
+    uint16_t duty = 0;
+    uint32_t ns = 0;
+
+    switch(meas_sel)
+    {
+        case MEAS_VPP:
+            mv = (maxMv - minMv) * 2;
+            break;
+        case MEAS_MEAN:
+            mv = meanMv * 2;
+            break;
+        case MEAS_RMS:
+            mv = rmsMv * 2;
+            break;
+        case MEAS_DUTY:
+            /* The frequency input measures duty in hardware, the record is the fallback */
+            duty = get_freq_duty_value();
+            if(duty == 0)
+                duty = res->duty;
+            sprintf(buf,"%d.%d%%",duty / 10,duty % 10);
+            return;
+        case MEAS_PERIOD:
+            ns = res->period_ns;
+            break;
+        case MEAS_RISE:
+            ns = res->rise_ns;
+            break;
+        default:
+            ns = res->fall_ns;
+            break;
+    }
+
+    if((meas_sel == MEAS_VPP) || (meas_sel == MEAS_MEAN) || (meas_sel == MEAS_RMS))
+    {
+        /* Round to 10mV */
+        mv = mv + 5;
+        sprintf(buf,"%d.%02dV",mv / 1000,(mv % 1000) / 10);
+    }
+    else if(ns == 0)
+    {
+        strcpy(buf,"--");
+    }
+    else
+    {
+        osc_format_time(buf,ns);
+    }
+}
+
+/*
+ * Frequency in 0.01Hz to an 8 character label: 12.34Hz, 999Hz, 12.5KHz
+ */
+static void osc_format_freq(char *buf, uint32_t chz)
+{
+    uint32_t hz = (chz + 50U) / 100U;
+
+    if((hz < 100) && (hz != 0))
+    {
+        /* Low frequencies resolve to 0.01Hz */
+        sprintf(buf,"%2d.%02dHz ",(uint16_t)(chz / 100),(uint16_t)(chz % 100));
+    }
+    else if(hz >= 1000)
+    {
+        hz = hz + 50;	/* Round to 0.1KHz */
+        sprintf(buf,"%3d.%dKHz",(uint16_t)(hz / 1000),(uint16_t)((hz % 1000) / 100));
+    }
+    else
+    {
+        sprintf(buf,"%4dHz  ",(uint16_t)hz);
+    }
+}
+
+/*
+ * Show oscilloscope info: status row, selected measurement and frequency
  */
 void TFT_ShowOscInfo(void)
 {
-    uint32_t freq = 0;
+    char label[8]={0};
     char showData[32]={0};
 
-    sprintf(showData,"%1.2fV ",(maxVol - minVol) * 2);
-    TFT_ShowString(34,112,(uint8_t *)showData,YELLOW,DARKBLUE,16,0);
+    if(get_adc_acq_mode() == ADC_ACQ_ETS)
+    {
+        osc_format_time(label,osc_sample_ns() * ADC_DIV_SAMPLES);
+    }
+    else
+    {
+        strcpy(label,get_adc_timebase_info()->label);
+    }
+
+    /* Timebase and acquisition mode in the top-left corner, above the highest reachable trace row */
+    sprintf(showData,"%-5s/div %s %s x%d",label,
+            (get_adc_acq_mode() == ADC_ACQ_ETS) ? "ET" :
+            ((get_adc_peak_ratio() > 0) ? "PK" : ((get_adc_sample_bits() > 12) ? "HR" :
+            ((get_adc_acq_mode() == ADC_ACQ_PACK8) ? "8B" : "  "))),
+            get_osc_roll_active() ? "ROL" : ((get_adc_trigger_source() == ADC_TRIG_SRC_CMP) ? "CMP" : trig_label[get_adc_trigger_mode()]),
+            1 << osc_vscale);
+    TFT_FieldShow(&info_field[INFO_TOP],showData,WHITE,BLACK);
+    memset(showData,0,32);
+
+    /* Only Vpp is tracked while rolling */
+    TFT_FieldShow(&info_field[INFO_LABEL],meas_label[meas_sel],WHITE,DARKBLUE);
+    if(get_osc_roll_active() && (meas_sel != MEAS_VPP))
+        strcpy(label,"--");
+    else
+        osc_format_measure(label);
+    sprintf(showData,"%-6s",label);
+    TFT_FieldShow(&info_field[INFO_VALUE],showData,YELLOW,DARKBLUE);
     memset(showData,0,32);
 
-    freq = get_freq_value();
-    if(freq >= 1000)
+    osc_format_freq(showData,get_freq_centi_value());
+    TFT_FieldShow(&info_field[INFO_FREQ],showData,YELLOW,DARKBLUE);
+
+    TFT_ShowTrigLevel();
+}
+
+/*
+ * Trigger level marker right of the wave area, follows the adaptive level
+ */
+void TFT_ShowTrigLevel(void)
+{
+    uint16_t level = get_adc_trigger_level();
+    uint8_t bits = get_adc_sample_bits();
+    int16_t y = 0;
+
+    /* Level is kept in 12-bit units, the screen scale follows the sample width */
+    if(bits > 12)
+        level <<= (bits - 12);
+    else
+        level >>= (12 - bits);
+    y = osc_count_to_y(level);
+    if(y < 22)
+        y = 22;
+    if(y == trig_level_y)
+        return;
+
+    if(trig_level_y >= 0)
+        TFT_Fill(156,trig_level_y - 1,160,trig_level_y + 2,BLACK);
+    else
+        TFT_Fill(155,21,160,111,BLACK);
+    TFT_Fill(156,y - 1,160,y + 2,YELLOW);
+    trig_level_y = y;
+}
+
+/*
+ * Spectrum page static UI (PAGE_FFT)
+ */
+void TFT_FftStaticUI(void)
+{
+    uint16_t i=0;
+
+    for(i=0;i<=110;i++)
+    {
+        TFT_DrawPoint(0,i,GREEN);   /* left vertical axis */
+    }
+    TFT_Fill(0,112,160,128,DARKBLUE);
+
+    TFT_FieldInit(&info_field[INFO_TOP],2,0,16);
+    TFT_FieldInit(&info_field[INFO_LABEL],2,112,16);
+    TFT_FieldInit(&info_field[INFO_VALUE],34,112,16);
+}
+
+/*
+ * Clear the spectrum area, the next frame redraws every column
+ */
+static void osc_fftClear(void)
+{
+    uint16_t i=0;
+
+    TFT_Fill(1,21,wave_width,FFT_Y_BOTTOM + 1,BLACK);
+    for(i=0;i<wave_width;i++)
+    {
+        oldWave[i] = FFT_Y_BOTTOM;
+    }
+}
+
+/*
+ * Spectrum page info: window and span, strongest component
+ * Harmonic view: fundamental and THD
+ */
+void TFT_ShowFftUI(void)
+{
+    uint16_t ref = FFT_LEVEL_FS - ((fft_window == FFT_WIN_HANN) ? FFT_HANN_GAIN : 0);
+    char label[12]={0};
+    char showData[32]={0};
+
+    if(fft_view == FFT_VIEW_HARM)
     {
-        sprintf(showData,"%3.1fKHz",(freq / 1000.0f));
-        TFT_ShowString(96,112,(uint8_t *)showData,YELLOW,DARKBLUE,16,0);
+        osc_format_freq(label,harm_chz);
+        sprintf(showData,"HARM F:%s",label);
+        TFT_FieldShow(&info_field[INFO_TOP],showData,WHITE,BLACK);
         memset(showData,0,32);
+
+        TFT_FieldShow(&info_field[INFO_LABEL],"THD:",WHITE,DARKBLUE);
+        if(harm_res.num > 1)
+            sprintf(showData,"%3d.%02d%% %4ddB ",harm_res.thd / 100,harm_res.thd % 100,harm_res.level[0] / 10);
+        else
+            strcpy(showData,"--             ");
+        TFT_FieldShow(&info_field[INFO_VALUE],showData,YELLOW,DARKBLUE);
+        return;
+    }
+
+    /* Span is DC to half the sample rate */
+    osc_format_freq(label,(fft_sample_ns != 0) ? (uint32_t)(50000000000ULL / fft_sample_ns) : 0U);
+    sprintf(showData,"%s 0-%s",(fft_window == FFT_WIN_HANN) ? "HANN" : "RECT",label);
+    TFT_FieldShow(&info_field[INFO_TOP],showData,WHITE,BLACK);
+    memset(showData,0,32);
+
+    TFT_FieldShow(&info_field[INFO_LABEL],"Pk: ",WHITE,DARKBLUE);
+    if((fft_peak_chz != 0) && (fft_peak_level + FFT_RANGE >= ref + FFT_PEAK_MIN))
+    {
+        osc_format_freq(label,fft_peak_chz);
+        sprintf(showData,"%s %4ddB",label,((int16_t)fft_peak_level - (int16_t)ref) / 10);
     }
     else
     {
-        sprintf(showData,"%4dHz",freq);
-        TFT_ShowString(96,112,(uint8_t *)showData,YELLOW,DARKBLUE,16,0);
-        memset(showData,0,32);
+        strcpy(showData,"--             ");
     }
+    TFT_FieldShow(&info_field[INFO_VALUE],showData,YELLOW,DARKBLUE);
 }
-
 /*
  * PWM page static UI (PAGE_PWM)
  */
@@ -201,6 +510,10 @@ void TFT_PwmStaticUI(void)
 
     TFT_Fill(0,108,160,128,DARKBLUE);
     TFT_ShowString(2,110,(uint8_t *)"K1:SW K2:Frq K3:Dty",YELLOW,DARKBLUE,16,0);
+
+    TFT_FieldInit(&info_field[INFO_PWM_STATE],74,30,16);
+    TFT_FieldInit(&info_field[INFO_PWM_FREQ],74,52,16);
+    TFT_FieldInit(&info_field[INFO_PWM_DUTY],74,74,16);
 }
 
 /*
@@ -214,27 +527,27 @@ void TFT_ShowPwmUI(void)
     pwm_state = get_pwm_state();
     if(pwm_state == PWM_ON)
     {
-        TFT_ShowString(74,30,(uint8_t *)" ON ",BLACK,GREEN,16,0);
+        TFT_FieldShow(&info_field[INFO_PWM_STATE]," ON ",BLACK,GREEN);
     }
     else
     {
-        TFT_ShowString(74,30,(uint8_t *)" OFF",BLACK,RED,16,0);
+        TFT_FieldShow(&info_field[INFO_PWM_STATE]," OFF",BLACK,RED);
     }
 
     if(get_pwm_out_freq() >= 1000)
     {
         sprintf(showData,"%3dKHz ",get_pwm_out_freq()/1000);
-        TFT_ShowString(74,52,(uint8_t *)showData,BLACK,YELLOW,16,0);
+        TFT_FieldShow(&info_field[INFO_PWM_FREQ],showData,BLACK,YELLOW);
         memset(showData,0,32);
     }
     else
     {
         sprintf(showData,"%4dHz ",get_pwm_out_freq());
-        TFT_ShowString(74,52,(uint8_t *)showData,BLACK,YELLOW,16,0);
+        TFT_FieldShow(&info_field[INFO_PWM_FREQ],showData,BLACK,YELLOW);
         memset(showData,0,32);
     }
     sprintf(showData," %2d%% ",(uint16_t)((get_pwm_duty()*1.0f / get_pwm_period()) * 100));
-    TFT_ShowString(74,74,(uint8_t *)showData,BLACK,YELLOW,16,0);
+    TFT_FieldShow(&info_field[INFO_PWM_DUTY],showData,BLACK,YELLOW);
     memset(showData,0,32);
 }
 
@@ -244,20 +557,7 @@ void TFT_ShowPwmUI(void)
  */
 void TFT_DrawKanade(void)
 {
-    uint16_t i = 0;
-    uint8_t count, idx;
-
-    TFT_Address_Set(0, 0, KANADE_IMG_W - 1, KANADE_IMG_H - 1);
-
-    for(i = 0; i < KANADE_RLE_SIZE; i += 2)
-    {
-        count = kanade_rle_data[i];
-        idx   = kanade_rle_data[i + 1];
-        while(count--)
-        {
-            TFT_WR_DATA(kanade_palette[idx]);
-        }
-    }
+    TFT_DrawRLE(0, 0, KANADE_IMG_W, KANADE_IMG_H, kanade_rle_data, KANADE_RLE_SIZE, kanade_palette);
 }
 
 /*
@@ -287,6 +587,16 @@ void key_scanf_handle(const uint16_t key_pin,const uint8_t key_state)
 						set_pwm_state(PWM_OFF);
 					}
 				}
+				else if(current_page == PAGE_OSC)
+				{
+					/* Cycle acquisition mode */
+					set_adc_acq_mode(get_adc_acq_mode() + 1);
+				}
+				else if(current_page == PAGE_FFT)
+				{
+					/* Toggle spectrum window */
+					fft_window = (fft_window + 1) % FFT_WIN_MAX;
+				}
 				break;
 			case KeyDoublePress:
 				switch_page();
@@ -300,6 +610,35 @@ void key_scanf_handle(const uint16_t key_pin,const uint8_t key_state)
 		switch(key_state)
 		{
 			case KeyPress:
+				if(current_page == PAGE_OSC)
+				{
+					/* Cycle trigger: watchdog modes, then the comparator (rising), then back */
+					if(get_adc_trigger_source() == ADC_TRIG_SRC_CMP)
+					{
+						set_adc_trigger_source(ADC_TRIG_SRC_WDG);
+						set_adc_trigger_mode(TRIG_MODE_RISE);
+					}
+					else if(get_adc_trigger_mode() == TRIG_MODE_MAX - 1)
+					{
+						set_adc_trigger_source(ADC_TRIG_SRC_CMP);
+					}
+					else
+					{
+						set_adc_trigger_mode(get_adc_trigger_mode() + 1);
+					}
+					break;
+				}
+				if(current_page == PAGE_FFT)
+				{
+					/* Spectrum / harmonic analysis */
+					fft_view = (fft_view + 1) % FFT_VIEW_MAX;
+					osc_fftClear();
+					break;
+				}
+				if(current_page != PAGE_PWM)
+				{
+					break;
+				}
 				temp_duty = (get_pwm_duty()*1.0f / get_pwm_period());
 				temp_period = get_pwm_period();
 				temp_period = temp_period / 2;
@@ -310,6 +649,13 @@ void key_scanf_handle(const uint16_t key_pin,const uint8_t key_state)
 				set_pwm_period(temp_period);
 				set_pwm_duty(temp_period * temp_duty);
 				break;
+			case KeyDoublePress:
+				if(current_page == PAGE_OSC)
+				{
+					/* Toggle roll mode, used from ADC_ROLL_TB_MIN */
+					set_osc_roll(!get_osc_roll());
+				}
+				break;
 			default:
 				break;
 		}
@@ -319,6 +665,19 @@ void key_scanf_handle(const uint16_t key_pin,const uint8_t key_state)
 		switch(key_state)
 		{
 			case KeyPress:
+				if(current_page == PAGE_OSC)
+				{
+					/* Step trigger position by a quarter screen: 0, 1/4, 1/2, 3/4 */
+					temp_period = (get_adc_trigger_pre() * 4 + wave_width / 2) / wave_width;
+					temp_period = (temp_period + 1) % 4;
+					set_adc_trigger_pre(temp_period * wave_width / 4);
+					TFT_ShowTrigPos();
+					break;
+				}
+				if(current_page != PAGE_PWM)
+				{
+					break;
+				}
 				temp_duty = get_pwm_period() * 0.04f + get_pwm_duty();
 				if(temp_duty > get_pwm_period())
 				{
@@ -327,6 +686,16 @@ void key_scanf_handle(const uint16_t key_pin,const uint8_t key_state)
 				set_pwm_duty(temp_duty);
 				break;
 			case KeyDoublePress:
+				if(current_page == PAGE_OSC)
+				{
+					/* Cycle the measurement shown in the bottom bar */
+					meas_sel = (meas_sel + 1) % MEAS_MAX;
+					break;
+				}
+				if(current_page != PAGE_PWM)
+				{
+					break;
+				}
 				temp_duty = get_pwm_duty() - get_pwm_period() * 0.04f;
 				if(temp_duty < 0)
 				{
@@ -334,6 +703,14 @@ void key_scanf_handle(const uint16_t key_pin,const uint8_t key_state)
 				}
 				set_pwm_duty(temp_duty);
 				break;
+			case KeyLongPress:
+				if(current_page == PAGE_OSC)
+				{
+					/* Step the adaptive trigger level: 50%, 75%, 25% of the swing */
+					set_adc_trigger_percent((get_adc_trigger_percent() == 50) ? 75 :
+					                        ((get_adc_trigger_percent() == 75) ? 25 : 50));
+				}
+				break;
 			default:
 				break;
 		}
@@ -352,6 +729,14 @@ void key_scanf_handle(const uint16_t key_pin,const uint8_t key_state)
 					set_osc_stop_bit(OSC_RUN);
 				}
 				break;
+			case KeyLongPress:
+				if(current_page == PAGE_OSC)
+				{
+					/* Autoset: timebase, vertical scale and trigger level from a pre-capture */
+					osc_autoset();
+					set_osc_stop_bit(OSC_RUN);
+				}
+				break;
 			default:
 				break;
 		}
@@ -367,6 +752,10 @@ void TFT_ShowUI(void)
 	{
 		TFT_ShowOscInfo();
 	}
+	else if(current_page == PAGE_FFT)
+	{
+		TFT_ShowFftUI();
+	}
 	else if(current_page == PAGE_PWM)
 	{
 		TFT_ShowPwmUI();
@@ -375,92 +764,553 @@ void TFT_ShowUI(void)
 }
 
 /*
-*   Waveform display with improved ADC accuracy
+*   Function: Check whether the waveform rolls instead of being drawn frame by frame
+*   Parameters: None
+*   Return: 1 - roll mode selected and usable at the current timebase, 0 - otherwise
 */
-void osc_waveShow(uint16_t vref_value)
+uint8_t get_osc_roll_active(void)
 {
-	uint16_t i = 0, t = 0, num = 0;
-	int16_t prePos = 0;
-	uint16_t v_max = 0, v_min = 4095;
-	uint16_t sample_count = 0;
-	float voltage_scale = 0.0f;
+	return (osc_roll != 0) && (get_adc_timebase_value() >= ADC_ROLL_TB_MIN) &&
+	       (get_adc_acq_mode() != ADC_ACQ_ETS);
+}
 
-	if(get_adc_convert_value() != ADC_CONVERT_FINSIH)
+/*
+*   Function: Select roll mode, it takes effect from ADC_ROLL_TB_MIN
+*   Parameters: value - 1 on, 0 off
+*   Return: None
+*/
+void set_osc_roll(uint8_t value)
+{
+	osc_roll = value;
+}
+
+/*
+*   Function: Get the roll mode selection
+*   Parameters: None
+*   Return: 1 on, 0 off
+*/
+uint8_t get_osc_roll(void)
+{
+	return osc_roll;
+}
+
+/*
+ * Recompute the Q16 count-to-millivolt and count-to-pixel factors
+ * Only runs when the Vrefint reading or the sample width changed, the hot path stays integer
+ */
+static void osc_scale_update(uint16_t vref_value)
+{
+	uint8_t bits = get_adc_sample_bits();
+	uint8_t ppv = osc_vscale_tab[osc_vscale];
+	uint32_t mv_q16 = 0;
+
+	if((vref_value == scale_vref) && (bits == scale_bits) && (ppv == scale_ppv))
 		return;
+	scale_vref = vref_value;
+	scale_bits = bits;
+	scale_ppv = ppv;
 
-	/* Pre-compute voltage scale factor: (1.20 / vref_value) * 20 */
-	/* 1.20V is the typical Vrefint for GD32E230 */
+	/* A 12-bit count of vref_value is 1.20V, without a reading assume 3.3V full scale */
 	if(vref_value > 0)
-		voltage_scale = (1.20f * 20.0f) / (float)vref_value;
+		mv_q16 = ((uint32_t)vrefint_mv << 16) / vref_value;
 	else
-		voltage_scale = (3.3f * 20.0f) / 4095.0f;
+		mv_q16 = (3300UL << 16) / 4095U;
+
+	/* High-res samples carry extra bits over the 12-bit Vrefint reading, fast and packed ones fewer */
+	if(bits < 12)
+		mv_q16 <<= (12 - bits);
+	else
+		mv_q16 >>= (bits - 12);
+
+	scale_mv_q16 = mv_q16;
+	scale_px_q16 = (mv_q16 * ppv + 500U) / 1000U;
+	scale_base_px = (uint16_t)(((uint32_t)osc_base_mv * ppv + 500U) / 1000U);
+}
+
+/*
+ * ADC count to screen Y coordinate, clamped to the wave area
+ */
+static int16_t osc_count_to_y(uint16_t count)
+{
+	uint32_t pix = ((uint32_t)count * scale_px_q16 + 0x8000U) >> 16;
+
+	pix = (pix > scale_base_px) ? (pix - scale_base_px) : 0U;
+	if(pix > wave_rows - 1)
+		pix = wave_rows - 1;
 
-	/* Step 1: Convert raw ADC to display values, track min/max on raw data */
-	for(i = 0; i < ADC_NUM && num < ADC_NUM; i += step_value)
+	/* Transform to screen Y coordinate (inverted) */
+	return (int16_t)(110 - pix);
+}
+
+/*
+ * ADC count to millivolts at the ADC pin
+ */
+static uint16_t osc_count_to_mv(uint16_t count)
+{
+	return (uint16_t)(((uint32_t)count * scale_mv_q16 + 0x8000U) >> 16);
+}
+
+/*
+ * Erase data of another drawing style does not match, start from a clean screen
+ */
+static void osc_waveStyle(uint8_t style)
+{
+	if(style == wave_style)
+		return;
+
+	TFT_Fill(1,21,wave_width,111,BLACK);
+	TFT_OscStaticUI();
+	osc_spanClear();
+	wave_style = style;
+}
+
+/*
+ * Nothing on screen in the wave area, the next frame draws every column whole
+ */
+static void osc_spanClear(void)
+{
+	uint16_t i = 0;
+
+	for(i = 0; i < wave_width; i++)
 	{
-		/* Track min/max on raw ADC values for accurate voltage measurement */
-		if(adc_value[i] < v_min)
-			v_min = adc_value[i];
-		if(adc_value[i] > v_max)
-			v_max = adc_value[i];
-
-		/* Convert to display coordinates with proper rounding */
-		adc_value2[num] = (uint16_t)(adc_value[i] * voltage_scale + 0.5f);
-
-		/* Clamp to display range before coordinate transform */
-		if(adc_value2[num] > 110)
-			adc_value2[num] = 110;
-
-		/* Transform to screen Y coordinate (inverted) */
-		adc_value2[num] = 110 - adc_value2[num];
-		num++;
+		oldWave[i] = span_none;
+		oldLow[i] = span_none - 1;
 	}
+}
 
-	sample_count = num;
+/*
+ * Update one column from the old span to the new one, only the rows that change are written
+ * An address window costs 11 bytes on the bus, about 5 pixels, so the changes above and
+ * below the overlap share one window when at most span_merge unchanged rows lie between them
+ */
+static void osc_spanUpdate(uint16_t x, int16_t old_top, int16_t old_bottom, int16_t top, int16_t bottom)
+{
+	int16_t gap = 0;
 
-	/* Step 2: Rising edge trigger detection within valid range */
-	t = 0;
-	if(sample_count > wave_width)
+	if((old_top == top) && (old_bottom == bottom))
+		return;
+
+	if((old_top > old_bottom) || (old_bottom < top) || (bottom < old_top))
 	{
-		for(i = 0; i < (sample_count - wave_width - 1); i++)
+		/* Empty before or no overlap: erase the old span whole, draw the new one whole */
+		if(old_top <= old_bottom)
 		{
-			/* Rising edge: current above threshold, next below (inverted Y) */
-			if((adc_value2[i] > volThreshold) && (adc_value2[i + 1] <= volThreshold))
+			gap = (top > old_bottom) ? (top - old_bottom - 1) : (old_top - bottom - 1);
+			if(gap <= span_merge)
 			{
-				t = i;
-				break;
+				TFT_DrawSpan(x, (top < old_top) ? top : old_top, (bottom > old_bottom) ? bottom : old_bottom,
+				             top, bottom, GREEN, BLACK);
+				return;
 			}
+			TFT_Fill(x, old_top, x + 1, old_bottom + 1, BLACK);
 		}
+		TFT_Fill(x, top, x + 1, bottom + 1, GREEN);
+		return;
 	}
 
-	/* Step 3: Extract display data from trigger point */
-	for(i = 0; i < wave_width; i++)
+	/* Overlap: only the rows above and below it change */
+	gap = ((bottom < old_bottom) ? bottom : old_bottom) - ((top > old_top) ? top : old_top) + 1;
+	if((top != old_top) && (bottom != old_bottom) && (gap <= span_merge))
 	{
-		if((t + i) < sample_count)
-			newWave[i] = adc_value2[t + i];
-		else
+		TFT_DrawSpan(x, (top < old_top) ? top : old_top, (bottom > old_bottom) ? bottom : old_bottom,
+		             top, bottom, GREEN, BLACK);
+		return;
+	}
+	if(old_top < top)
+		TFT_Fill(x, old_top, x + 1, top, BLACK);
+	else if(top < old_top)
+		TFT_Fill(x, top, x + 1, old_top, GREEN);
+	if(old_bottom > bottom)
+		TFT_Fill(x, bottom + 1, x + 1, old_bottom + 1, BLACK);
+	else if(bottom > old_bottom)
+		TFT_Fill(x, old_bottom + 1, x + 1, bottom + 1, GREEN);
+}
+
+/*
+*   Roll display: new samples enter at the right edge as soon as DMA wrote them
+*   newWave/newLow hold the span of every column and shift left by the number of new
+*   samples, oldWave/oldLow hold what is on screen so each column only writes its difference
+*/
+void osc_rollShow(uint16_t vref_value)
+{
+	uint16_t hi[roll_chunk];
+	uint16_t lo[roll_chunk];
+	uint16_t i = 0, num = 0, total = 0;
+	int16_t top = 0, bottom = 0, y_top = 110, y_bottom = 0;
+
+	osc_scale_update(vref_value);
+
+	if(wave_style != WAVE_STYLE_ROLL)
+	{
+		osc_waveStyle(WAVE_STYLE_ROLL);
+		adc_roll_start();
+		for(i = 0; i < wave_width; i++)
+		{
 			newWave[i] = 110;
+			newLow[i] = 110;
+		}
+	}
+
+	while((num = adc_roll_read(hi, lo, roll_chunk)) > 0)
+	{
+		memmove(&newWave[0], &newWave[num], (wave_width - num) * sizeof(newWave[0]));
+		memmove(&newLow[0], &newLow[num], (wave_width - num) * sizeof(newLow[0]));
+		for(i = 0; i < num; i++)
+		{
+			newWave[wave_width - num + i] = osc_count_to_y(hi[i]);
+			newLow[wave_width - num + i] = (uint8_t)osc_count_to_y(lo[i]);
+		}
+		total += num;
 	}
+	if(total == 0)
+		return;
+
+	for(i = 1; i < wave_width - 2; i++)
+	{
+		top = newWave[i];
+		bottom = newLow[i];
+		/* Stretch the span to meet the previous column so steep edges stay connected */
+		if(top > newLow[i - 1])
+			top = newLow[i - 1];
+		if(bottom < newWave[i - 1])
+			bottom = newWave[i - 1];
+		osc_spanUpdate(i, oldWave[i], oldLow[i], top, bottom);
+		oldWave[i] = top;
+		oldLow[i] = (uint8_t)bottom;
+
+		if(newWave[i] < y_top)
+			y_top = newWave[i];
+		if(newLow[i] > y_bottom)
+			y_bottom = newLow[i];
+	}
+
+	/* Screen resolution is enough for the Vpp readout while rolling */
+	maxMv = (uint16_t)(osc_base_mv + (110 - y_top) * 1000 / osc_vscale_tab[osc_vscale]);
+	minMv = (uint16_t)(osc_base_mv + (110 - y_bottom) * 1000 / osc_vscale_tab[osc_vscale]);
+}
+
+/*
+*   Waveform display with improved ADC accuracy
+*/
+void osc_waveShow(uint16_t vref_value)
+{
+	uint16_t i = 0;
+	int16_t prePos = 0, top = 0, bottom = 0, mid = 0;
+	uint8_t triggered = 0;
+	uint8_t peak = (get_adc_peak_ratio() > 0);
+	const uint16_t *raw = NULL;
+	const uint16_t *raw_min = NULL;
+
+	if(get_adc_trigger_state() == ADC_TRIG_READY)
+	{
+		/* Hardware trigger latched a complete pre/post trigger window */
+		raw = get_adc_trigger_window();
+		triggered = 1;
+	}
+	else if((get_adc_convert_value() == ADC_CONVERT_FINSIH) && (get_adc_acq_mode() != ADC_ACQ_ETS))
+	{
+		/* Auto: no trigger this frame, show the newest samples the DMA interrupt copied out */
+		/* Not in equivalent-time mode, raw samples are on a different time scale */
+		raw = get_adc_trigger_window();
+	}
+	else
+	{
+		return;
+	}
+
+	/* Peak detect: raw holds the column maximum, raw_min the minimum */
+	raw_min = peak ? get_adc_trigger_window_min() : raw;
+
+	osc_scale_update(vref_value);
 
-	/* Step 4: Draw waveform */
+	/* Step 1: Convert the window to display values */
+	/* Every sample is used, the sample interval is set by the TIMER0 timebase */
+	/* Min/max, mean, RMS and edge timing accumulate in the same single pass */
+	measure_begin(get_adc_sample_bits());
+	for(i = 0; i < wave_width; i++)
+	{
+		/* Q16 multiply with rounding, no soft-float in the per-sample path */
+		newWave[i] = osc_count_to_y(raw[i]);
+		newLow[i] = (uint8_t)osc_count_to_y(raw_min[i]);
+		measure_sample(raw[i], raw_min[i]);
+	}
+
+	/* Auto window consumed, the next completed half refills it */
+	/* A trigger completed during conversion and overwrote the window - skip frame, show it next */
+	/* Checked before the measurement closes so a torn window never reaches the results or the tracker */
+	if(!triggered)
+	{
+		set_adc_convert_value(ADC_CONVERT_UN_FINSIH);
+		if(get_adc_trigger_state() == ADC_TRIG_READY)
+			return;
+	}
+
+	measure_end(osc_sample_ns());
+	adc_trigger_track(get_measure_result()->min, get_measure_result()->max);
+
+	osc_waveStyle(peak ? WAVE_STYLE_SPAN : WAVE_STYLE_LINE);
+
+	/* Step 2: Draw each column as one vertical span, only the rows that differ from the */
+	/* previous frame go out over SPI, a column that did not change costs nothing */
 	prePos = newWave[0];
 	for(i = 1; i < wave_width - 2; i++)
 	{
-		TFT_DrawLine(i, oldWave[i], i + 1, oldWave[i + 1], BLACK);
-		TFT_DrawLine(i, prePos, i + 1, newWave[i], GREEN);
-		prePos = newWave[i];
+		if(peak)
+		{
+			/* Min/max span, stretched to meet the previous column so steep edges stay connected */
+			top = newWave[i];
+			bottom = newLow[i];
+			if(top > newLow[i - 1])
+				top = newLow[i - 1];
+			if(bottom < newWave[i - 1])
+				bottom = newWave[i - 1];
+		}
+		else
+		{
+			/* Line: the sample joined to the midpoints towards both neighbours, neighbouring */
+			/* columns share the midpoint row so the trace stays connected */
+			top = newWave[i];
+			bottom = newWave[i];
+			mid = (prePos + newWave[i]) / 2;
+			if(mid < top)
+				top = mid;
+			if(mid > bottom)
+				bottom = mid;
+			mid = (newWave[i] + newWave[i + 1]) / 2;
+			if(mid < top)
+				top = mid;
+			if(mid > bottom)
+				bottom = mid;
+			prePos = newWave[i];
+		}
+		osc_spanUpdate(i, oldWave[i], oldLow[i], top, bottom);
+		oldWave[i] = top;
+		oldLow[i] = (uint8_t)bottom;
+	}
+
+	/* Step 4: Calculate actual voltage from raw ADC min/max */
+	maxMv = osc_count_to_mv(get_measure_result()->max);
+	minMv = osc_count_to_mv(get_measure_result()->min);
+	meanMv = osc_count_to_mv(get_measure_result()->mean);
+	rmsMv = osc_count_to_mv(get_measure_result()->rms);
+
+	/* Window consumed, arm the hardware trigger for the next capture */
+	if(triggered)
+		adc_trigger_rearm();
+}
+
+/*
+*   Autoset: pre-captures AUTOSET_NUM samples at 1us, 10us and 100us until one shows at least
+*   three rising edges, then picks the fastest timebase that shows two periods, the largest
+*   vertical scale that fits the levels into AUTOSET_ROWS rows centred on the screen, and a
+*   trigger level halfway between them. Captures take at most ~30ms and each survey is a single
+*   pass over the samples, so it is done within one 500ms display frame.
+*   Acquisition returns to normal sampling, the other modes keep their own sample rates
+*/
+void osc_autoset(void)
+{
+	struct measure_survey sv;
+	uint16_t *buf = NULL;
+	uint32_t wait = 0, period_ns = 0, span_mv = 0, center_mv = 0, half_mv = 0, ns = 0;
+	uint16_t level = ADC_TRIG_LEVEL_DEF, hyst = ADC_TRIG_HYST_DEF;
+	uint8_t i = 0, bits = 0, flat = 0, tb = ADC_TIMEBASE_DEF;
+
+	set_adc_acq_mode(ADC_ACQ_NORMAL);
+	for(i = 0; i < sizeof(autoset_tb); i++)
+	{
+		set_adc_timebase_value(autoset_tb[i]);
+		adc_capture_resume();
+
+		/* Twice the capture time plus a tick of margin */
+		ns = get_adc_ring_sample_ns();
+		wait = AUTOSET_NUM * ns / 500000U + 2U;
+		while(!adc_capture_ready(AUTOSET_NUM) && (wait > 0))
+		{
+			delay_1ms(1);
+			wait--;
+		}
+		buf = adc_capture_freeze(AUTOSET_NUM);
+		bits = get_adc_sample_bits();
+		measure_survey(buf, AUTOSET_NUM, ns, bits, &sv);
+
+		/* A flat input looks the same at every rate */
+		flat = (((uint32_t)sv.high - sv.low) < ((1U << bits) >> 6));
+		if(flat || (sv.rises >= 3))
+			break;
+	}
+
+	if(!flat)
+	{
+		/* Fewer than two edges in the slowest pre-capture: the period is longer than it */
+		period_ns = sv.period_ns;
+		if(period_ns == 0)
+			period_ns = AUTOSET_NUM * ns;
+		for(tb = 0; tb < ADC_TIMEBASE_NUM - 1; tb++)
+		{
+			if(get_adc_timebase_entry(tb)->sample_ns * wave_width >= period_ns * 2U)
+				break;
+		}
+
+		/* Trigger halfway between the levels, hysteresis an eighth of the swing */
+		level = (uint16_t)(((uint32_t)sv.low + sv.high) / 2U);
+		hyst = (sv.high - sv.low) / 8U;
+		if(bits > 12)
+		{
+			level >>= (bits - 12);
+			hyst >>= (bits - 12);
+		}
+		else
+		{
+			level <<= (12 - bits);
+			hyst <<= (12 - bits);
+		}
+	}
+	set_adc_trigger_level(level, hyst);
+
+	/* Vertical scale from the levels of the last pre-capture */
+	osc_base_mv = 0;
+	osc_vscale = 0;
+	scale_ppv = 0;
+	osc_scale_update(scale_vref);
+	if(!flat)
+	{
+		span_mv = osc_count_to_mv(sv.high) - osc_count_to_mv(sv.low);
+		center_mv = ((uint32_t)osc_count_to_mv(sv.high) + osc_count_to_mv(sv.low)) / 2U;
+		while((osc_vscale < vscale_num - 1) &&
+		      (span_mv * osc_vscale_tab[osc_vscale + 1] <= AUTOSET_ROWS * 1000U))
+			osc_vscale++;
+		half_mv = (wave_rows / 2) * 1000U / osc_vscale_tab[osc_vscale];
+		osc_base_mv = (uint16_t)((center_mv > half_mv) ? (center_mv - half_mv) : 0U);
+	}
+	scale_ppv = 0;	/* Factors follow on the next frame */
+
+	set_adc_timebase_value(tb);
+	adc_capture_resume();
+
+	/* Restart drawing on a clean wave area with the new scale */
+	TFT_Fill(1,21,wave_width,111,BLACK);
+	TFT_OscStaticUI();
+	osc_spanClear();
+	wave_style = WAVE_STYLE_LINE;
+}
+
+/*
+*   Draw the bar tops in newWave against the baseline, only changed pixels are written
+*/
+static void osc_barShow(void)
+{
+	uint16_t i = 0;
+
+	for(i = 0; i < wave_width; i++)
+	{
+		osc_spanUpdate(i, oldWave[i], FFT_Y_BOTTOM, newWave[i], FFT_Y_BOTTOM);
+		oldWave[i] = newWave[i];
 	}
+}
+
+/*
+*   Level in 0.1dB relative to the top of the spectrum area to a bar top row
+*/
+static int16_t osc_barTop(int32_t level)
+{
+	int32_t top = FFT_Y_BOTTOM - (level + FFT_RANGE) * (FFT_Y_BOTTOM - FFT_Y_TOP) / FFT_RANGE;
+
+	if(top < FFT_Y_TOP)
+		top = FFT_Y_TOP;
+	if(top > FFT_Y_BOTTOM)
+		top = FFT_Y_BOTTOM;
+	return (int16_t)top;
+}
+
+/*
+*   Spectrum: the newest FFT_N samples are transformed in place in the ADC ring
+*   Sampling pauses for the transform and restarts on an empty ring, the next frame waits
+*   until FFT_N new samples are in. Bins are reduced to one peak per column and drawn as spans
+*/
+static void osc_spectrumShow(void)
+{
+	uint16_t *level = NULL;
+	uint16_t i = 0, bin = 0, end = 0, peak = 0, ref = 0;
+
+	if(!adc_capture_ready(FFT_N))
+		return;
 
-	/* Step 5: Save current waveform for next erase */
-	for(i = 1; i < wave_width; i++)
+	ref = FFT_LEVEL_FS - ((fft_window == FFT_WIN_HANN) ? FFT_HANN_GAIN : 0);
+	fft_sample_ns = get_adc_ring_sample_ns();
+	level = adc_capture_freeze(FFT_N);
+	fft_run(level, get_adc_sample_bits(), fft_window);
+
+	bin = fft_peak_bin(level);
+	fft_peak_level = level[bin];
+	fft_peak_chz = fft_peak_freq(level, bin, fft_sample_ns);
+
+	/* Column heights first so sampling restarts before the slow drawing */
+	bin = 0;
+	for(i = 0; i < wave_width; i++)
 	{
-		oldWave[i] = newWave[i - 1];
+		end = (uint16_t)(((uint32_t)(i + 1U) * FFT_BINS) / wave_width);
+		peak = 0;
+		for(; bin < end; bin++)
+		{
+			if(level[bin] > peak)
+				peak = level[bin];
+		}
+		newWave[i] = osc_barTop((int32_t)peak - ref);
 	}
+	adc_capture_resume();
+	osc_barShow();
+}
+
+/*
+*   Harmonics: Goertzel filters tuned to the frequency counter reading, run over a record
+*   of whole periods taken from the ADC ring in place. One bar per harmonic in dBFS
+*/
+static void osc_harmShow(void)
+{
+	uint16_t *buf = NULL;
+	uint16_t i = 0, num = 0;
+	uint8_t h = 0;
+	int32_t level = 0;
 
-	/* Step 6: Calculate actual voltage from raw ADC min/max */
-	maxVol = (float)v_max * voltage_scale / 20.0f;
-	minVol = (float)v_min * voltage_scale / 20.0f;
+	harm_chz = get_freq_centi_value();
+	fft_sample_ns = get_adc_ring_sample_ns();
+	num = goertzel_record_len(harm_chz, fft_sample_ns, ADC_NUM);
+	if(num == 0)
+	{
+		/* No signal, or the timebase is too fast for one period */
+		harm_res.num = 0;
+	}
+	else
+	{
+		if(!adc_capture_ready(num))
+			return;
+		buf = adc_capture_freeze(num);
+		goertzel_harmonics(buf, num, get_adc_sample_bits(), fft_sample_ns, harm_chz, HARM_MAX, &harm_res);
+		adc_capture_resume();
+	}
 
-	clear_adc_value();
-	Restart_oscShowData();
+	for(i = 0; i < wave_width; i++)
+	{
+		h = i / HARM_SLOT;
+		newWave[i] = FFT_Y_BOTTOM;
+		if((h < harm_res.num) && ((i % HARM_SLOT) >= 4U) && ((i % HARM_SLOT) < HARM_SLOT - 4U))
+		{
+			level = harm_res.level[0];
+			if(h > 0)
+				level += harm_res.level[h];
+			newWave[i] = osc_barTop(level);
+		}
+	}
+	osc_barShow();
+}
+
+/*
+*   Spectrum page frame
+*/
+void osc_fftShow(void)
+{
+	if(fft_view == FFT_VIEW_HARM)
+		osc_harmShow();
+	else
+		osc_spectrumShow();
 }
@@ -9,14 +9,14 @@ void mx_adc_init(void)
 	/* Enable ADC clock */
 	rcu_periph_clock_enable(RCU_ADC);
 
-	/* Enable clock configuration, ADC clock = 28MHz */
+	/* Enable clock configuration, ADC clock = AHB/9 = 8MHz, fast timebases switch to IRC28M */
 	rcu_adc_clock_config(RCU_ADCCK_AHB_DIV9);
 
 	/* GPIO configuration: PA3 as analog input, no pull-up/down */
 	gpio_mode_set(GPIOA, GPIO_MODE_ANALOG, GPIO_PUPD_NONE, GPIO_PIN_3);
 
-	/* ADC continuous conversion mode enable */
-	adc_special_function_config(ADC_CONTINUOUS_MODE, ENABLE);
+	/* ADC continuous conversion mode disable - every conversion is paced by a trigger */
+	adc_special_function_config(ADC_CONTINUOUS_MODE, DISABLE);
 
 	/* ADC scan mode disable - single channel only */
 	adc_special_function_config(ADC_SCAN_MODE, DISABLE);
@@ -36,7 +36,7 @@ void mx_adc_init(void)
 	/* ADC temperature sensor and Vrefint enable */
   adc_tempsensor_vrefint_enable();
 
-	/* ADC external trigger configuration - software trigger */
+	/* ADC external trigger configuration - software trigger until acquisition starts */
 	adc_external_trigger_source_config(ADC_REGULAR_CHANNEL, ADC_EXTTRIG_REGULAR_NONE);
 	adc_external_trigger_config(ADC_REGULAR_CHANNEL, ENABLE);
 
@@ -51,8 +51,19 @@ void mx_adc_init(void)
 	/* DMA mode enable */
 	adc_dma_mode_enable();
 
-	/* ADC software trigger enable */
-	adc_software_trigger_enable(ADC_REGULAR_CHANNEL);
+	/* Analog watchdog on the signal channel, window covers full scale until a trigger is armed */
+	adc_watchdog_single_channel_enable(ADC_CHANNEL_3);
+	adc_watchdog_threshold_config(0U, 4095U);
+	adc_interrupt_flag_clear(ADC_INT_FLAG_WDE);
+	nvic_irq_enable(ADC_CMP_IRQn, 0U);
+}
+
+/*
+*   Switch regular channel conversions to the TIMER0 CH1 sample clock
+*/
+void mx_adc_timer_trigger_enable(void)
+{
+	adc_external_trigger_source_config(ADC_REGULAR_CHANNEL, ADC_EXTTRIG_REGULAR_T0_CH1);
 }
 
 void mx_adc_dma_init(uint32_t adc_value,uint32_t number)
@@ -81,15 +92,63 @@ void mx_adc_dma_init(uint32_t adc_value,uint32_t number)
 
     dma_channel_enable(DMA_CH0);                                    /* DMA channel 0 enable */
 
-    dma_interrupt_enable(DMA_CH0, DMA_CHXCTL_FTFIE);								/* Enable DMA full transfer interrupt */
+    dma_interrupt_enable(DMA_CH0, DMA_CHXCTL_HTFIE | DMA_CHXCTL_FTFIE);		/* Enable DMA half and full transfer interrupt (ping-pong) */
 }
 
-void mx_adc_dma_restart(uint32_t adc_value, uint32_t number)
+/*
+*   Restart the circular ADC DMA with a new buffer length and memory width
+*   The peripheral side stays 16-bit, a byte-wide memory side keeps the low byte of each result
+*/
+void mx_adc_dma_restart(uint32_t adc_value, uint32_t number, uint32_t memory_width)
 {
     dma_channel_disable(DMA_CH0);
     dma_interrupt_flag_clear(DMA_CH0, DMA_INT_FLAG_G);
+    dma_memory_width_config(DMA_CH0, memory_width);
     dma_memory_address_config(DMA_CH0, adc_value);
     dma_transfer_number_config(DMA_CH0, number);
-    dma_interrupt_enable(DMA_CH0, DMA_CHXCTL_FTFIE);
+    dma_interrupt_enable(DMA_CH0, DMA_CHXCTL_HTFIE | DMA_CHXCTL_FTFIE);
     dma_channel_enable(DMA_CH0);
 }
+
+/*
+*   Select ADC clock source and resolution, both can only change while the ADC is off
+*   IRC28M is not running after reset and is started on first use
+*/
+void mx_adc_clock_config(rcu_adc_clock_enum clock, uint32_t resolution)
+{
+	adc_disable();
+
+	if((clock == RCU_ADCCK_IRC28M) || (clock == RCU_ADCCK_IRC28M_DIV2))
+	{
+		rcu_osci_on(RCU_IRC28M);
+		rcu_osci_stab_wait(RCU_IRC28M);
+	}
+	rcu_adc_clock_config(clock);
+	adc_resolution_config(resolution);
+
+	adc_enable();
+	delay_1ms(1U);
+}
+
+/*
+*   Configure hardware oversampling, ratio/shift are ignored when disabled
+*   OVSAMPCTL can only be written while the ADC is off
+*/
+void mx_adc_oversample_config(ControlStatus enable, uint8_t ratio, uint16_t shift)
+{
+	adc_disable();
+
+	if(enable == ENABLE)
+	{
+		/* All oversampled conversions run back to back after each TIMER0 trigger */
+		adc_oversample_mode_config(ADC_OVERSAMPLING_ALL_CONVERT, shift, ratio);
+		adc_oversample_mode_enable();
+	}
+	else
+	{
+		adc_oversample_mode_disable();
+	}
+
+	adc_enable();
+	delay_1ms(1U);
+}
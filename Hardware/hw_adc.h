@@ -5,6 +5,9 @@
 
 void mx_adc_init(void);
 void mx_adc_dma_init(uint32_t adc_value,uint32_t number);
-void mx_adc_dma_restart(uint32_t adc_value, uint32_t number);
+void mx_adc_dma_restart(uint32_t adc_value, uint32_t number, uint32_t memory_width);
+void mx_adc_timer_trigger_enable(void);
+void mx_adc_oversample_config(ControlStatus enable, uint8_t ratio, uint16_t shift);
+void mx_adc_clock_config(rcu_adc_clock_enum clock, uint32_t resolution);
 
 #endif
@@ -0,0 +1,37 @@
+#include "hw_cmp.h"
+
+/*
+*   Function: Initialize the analog comparator as a hardware trigger source
+*   Parameters: None
+*   Return: None
+*   Note: The non-inverting input is fixed to PA1, which has to be tied to the probe net feeding PA3.
+*         The output drives TIMER0 CH0 input capture, so each crossing is timestamped by TIMER0.
+*/
+void mx_cmp_init(void)
+{
+	/* Enable GPIO and comparator clock */
+	rcu_periph_clock_enable(RCU_GPIOA);
+	rcu_periph_clock_enable(RCU_CFGCMP);
+
+	/* GPIO configuration: PA1 as analog input, no pull-up/down */
+	gpio_mode_set(GPIOA, GPIO_MODE_ANALOG, GPIO_PUPD_NONE, GPIO_PIN_1);
+
+	/* High speed mode, inverting input 1/2 Vrefint, middle hysteresis against noise */
+	cmp_mode_init(CMP_HIGHSPEED, CMP_1_2VREFINT, CMP_HYSTERESIS_MIDDLE);
+
+	/* Output routed to TIMER0 channel 0 input capture, rising edge = signal rising through the level */
+	cmp_output_init(CMP_OUTPUT_TIMER0IC0, CMP_OUTPUT_POLARITY_NOINVERTED);
+
+	/* Enabled when the comparator trigger source is selected */
+	cmp_disable();
+}
+
+/*
+*   Function: Select the comparator threshold
+*   Parameters: level - inverting input, one of the Vrefint fractions
+*   Return: None
+*/
+void mx_cmp_level_config(inverting_input_enum level)
+{
+	cmp_mode_init(CMP_HIGHSPEED, level, CMP_HYSTERESIS_MIDDLE);
+}
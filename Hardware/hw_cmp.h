@@ -0,0 +1,9 @@
+#ifndef __HW_CMP_H
+#define __HW_CMP_H
+
+#include "main.h"
+
+void mx_cmp_init(void);
+void mx_cmp_level_config(inverting_input_enum level);
+
+#endif
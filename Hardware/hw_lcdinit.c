@@ -1,6 +1,47 @@
 #include "hw_lcdinit.h"
+#include "hw_spi.h"
 #include "systick.h"
 
+static uint16_t tft_repeat = 0;				// Source of TFT_Window_Repeat, owned by the DMA until it finishes
+static volatile uint8_t tft_window_open = 0;	// CS is held low by an open window
+
+/*
+*   Function: DMA completion, the last byte has left the shifter
+*             A window ended while its pixels were queued is closed here
+*   Parameters: None
+*   Return value: None
+*/
+static void TFT_DMA_Done(void)
+{
+    if(!tft_window_open)
+        gpio_bit_write(LCD_CS_GPIO_Port,LCD_CS_Pin,SET);	// Pull up chip select signal
+}
+
+/*
+*   Function: Send one byte inside a window, CS and DC are already set
+*   Parameters: data---byte to send
+*   Return value: None
+*/
+static void TFT_SPI_Write(uint8_t data)
+{
+	while(spi_i2s_flag_get(SPI0,SPI_FLAG_TBE) == RESET);	// Wait for transmit buffer to be empty
+    spi_i2s_data_transmit(SPI0, data);  					// Send data
+}
+
+/*
+*   Function: Send a command inside a window, DC is left high for its parameters
+*   Parameters: reg---command
+*   Return value: None
+*/
+static void TFT_SPI_Command(uint8_t reg)
+{
+	spi0_flush();											// DC may only change between frames
+	gpio_bit_write(LCD_DC_GPIO_Port,LCD_DC_Pin,RESET);   // Pull down data/command signal
+	TFT_SPI_Write(reg);
+	spi0_flush();
+	gpio_bit_write(LCD_DC_GPIO_Port,LCD_DC_Pin,SET);     // Pull up data/command signal
+}
+
 /*
 *   Function: TFT sends a single byte of data
 *   Parameters: None
@@ -8,6 +49,8 @@
 */
 void TFT_WR_DATA8(uint8_t data)
 {
+	spi0_dma_wait();										// A queued transfer owns the bus and CS
+	spi0_frame_size(SPI_FRAMESIZE_8BIT);
     gpio_bit_write(LCD_CS_GPIO_Port,LCD_CS_Pin,RESET);   	// Pull down chip select signal
 
 	while(spi_i2s_flag_get(SPI0,SPI_FLAG_TBE) == RESET);	// Wait for transmit buffer to be empty
@@ -27,6 +70,8 @@ void TFT_WR_DATA(uint16_t data)
 	sendData[0] = (data>>8);
 	sendData[1] = (data);
 
+	spi0_dma_wait();										// A queued transfer owns the bus and CS
+	spi0_frame_size(SPI_FRAMESIZE_8BIT);
 	gpio_bit_write(LCD_CS_GPIO_Port,LCD_CS_Pin,RESET);   // Pull down chip select signal
 
 	while(spi_i2s_flag_get(SPI0,SPI_FLAG_TBE) == RESET);	// Wait for transmit buffer to be empty
@@ -44,6 +89,8 @@ void TFT_WR_DATA(uint16_t data)
 */
 void TFT_WR_REG(uint8_t reg)
 {
+	spi0_dma_wait();										// A queued transfer owns the bus and CS
+	spi0_frame_size(SPI_FRAMESIZE_8BIT);
 	gpio_bit_write(LCD_DC_GPIO_Port,LCD_DC_Pin,RESET);   // Pull down data/command signal
 	gpio_bit_write(LCD_CS_GPIO_Port,LCD_CS_Pin,RESET);   // Pull down chip select signal
 
@@ -65,6 +112,105 @@ void TFT_Address_Set(uint16_t x1,uint16_t y1,uint16_t x2,uint16_t y2)
 	TFT_WR_REG(0x2c);// Memory write
 }
 
+/*
+*   Function: Open a drawing window, CS stays low and DC high until TFT_Window_End
+*             Commands go out in 8-bit frames, then SPI0 switches to 16-bit frames so every
+*             pixel is a single frame without any per-pixel GPIO writes
+*   Parameters: x1,y1---start coordinates
+*               x2,y2---end coordinates, inclusive
+*   Return value: None
+*/
+void TFT_Window_Begin(uint16_t x1,uint16_t y1,uint16_t x2,uint16_t y2)
+{
+	spi0_dma_wait();										// Pixels of the previous window may still be queued
+	spi0_frame_size(SPI_FRAMESIZE_8BIT);
+	tft_window_open = 1;
+	gpio_bit_write(LCD_CS_GPIO_Port,LCD_CS_Pin,RESET);   // Pull down chip select signal
+
+	TFT_SPI_Command(0x2a);// Column address set
+	TFT_SPI_Write(x1>>8);
+	TFT_SPI_Write(x1);
+	TFT_SPI_Write(x2>>8);
+	TFT_SPI_Write(x2);
+	TFT_SPI_Command(0x2b);// Row address set
+	TFT_SPI_Write(y1>>8);
+	TFT_SPI_Write(y1);
+	TFT_SPI_Write(y2>>8);
+	TFT_SPI_Write(y2);
+	TFT_SPI_Command(0x2c);// Memory write
+	spi0_frame_size(SPI_FRAMESIZE_16BIT);
+}
+
+/*
+*   Function: Stream one pixel into the open window
+*   Parameters: color---pixel color
+*   Return value: None
+*/
+void TFT_Window_Pixel(uint16_t color)
+{
+	spi0_dma_wait();										// Keep the order behind a queued burst
+	while(spi_i2s_flag_get(SPI0,SPI_FLAG_TBE) == RESET);	// Wait for transmit buffer to be empty
+    spi_i2s_data_transmit(SPI0, color);  					// One 16-bit frame
+}
+
+/*
+*   Function: Stream num pixels of one color into the open window
+*             Runs of TFT_DMA_MIN pixels or more are queued from a fixed source and the call
+*             returns at once
+*   Parameters: color---color to fill
+*               num-----pixel count
+*   Return value: None
+*/
+void TFT_Window_Repeat(uint16_t color,uint32_t num)
+{
+	if(num < TFT_DMA_MIN)
+	{
+		while(num--)
+			TFT_Window_Pixel(color);
+		return;
+	}
+
+	spi0_dma_wait();
+	tft_repeat = color;
+	spi0_dma_repeat(&tft_repeat, num, TFT_DMA_Done);
+}
+
+/*
+*   Function: Queue num pixels from a RAM buffer into the open window and return, the buffer
+*             must not change before TFT_WR_WAIT or the next TFT write
+*   Parameters: buf---pixel buffer
+*               num---pixel count
+*   Return value: None
+*/
+void TFT_Window_Burst(const uint16_t *buf,uint16_t num)
+{
+	spi0_dma_send(buf, num, TFT_DMA_Done);
+}
+
+/*
+*   Function: Close the window, CS is released now or by the completion of queued pixels
+*   Parameters: None
+*   Return value: None
+*/
+void TFT_Window_End(void)
+{
+	tft_window_open = 0;
+	if(spi0_dma_busy())
+		return;
+	spi0_flush();
+	gpio_bit_write(LCD_CS_GPIO_Port,LCD_CS_Pin,SET);     // Pull up chip select signal
+}
+
+/*
+*   Function: Wait for the queued transfer to finish
+*   Parameters: None
+*   Return value: None
+*/
+void TFT_WR_WAIT(void)
+{
+	spi0_dma_wait();
+}
+
 void TFT_Init(void)
 {
 	gpio_bit_write(LCD_RES_GPIO_Port,LCD_RES_Pin,RESET);  	// Reset
@@ -14,10 +14,18 @@
 #define LCD_H 128
 #endif
 
+#define TFT_DMA_MIN      16		// Shorter pixel runs are cheaper to poll than to set up a DMA transfer
+
 void TFT_WR_DATA8(uint8_t data);
 void TFT_WR_DATA(uint16_t data);
 void TFT_WR_REG(uint8_t reg);
 void TFT_Address_Set(uint16_t x1,uint16_t y1,uint16_t x2,uint16_t y2);
+void TFT_Window_Begin(uint16_t x1,uint16_t y1,uint16_t x2,uint16_t y2);
+void TFT_Window_Pixel(uint16_t color);
+void TFT_Window_Repeat(uint16_t color,uint32_t num);
+void TFT_Window_Burst(const uint16_t *buf,uint16_t num);
+void TFT_Window_End(void);
+void TFT_WR_WAIT(void);
 void TFT_Init(void);
 
 #endif
@@ -1,4 +1,12 @@
 #include "hw_spi.h"
+#include "stddef.h"
+
+static const uint8_t *spi0_dma_src = NULL;      //һԴַ
+static uint32_t spi0_dma_left = 0;              //ʣ֡
+static uint8_t spi0_dma_step = 0;               //ÿ֡Դַֽ0Ϊ̶Դַ
+static uint16_t spi0_frame = SPI_FRAMESIZE_8BIT;//ǰ֡
+static spi_dma_callback spi0_dma_done = NULL;   //ɻص
+static volatile uint8_t spi0_dma_run = 0;       //б־
 
 /*
 *   ݣʼSPI0
@@ -41,4 +49,204 @@ void mx_spi0_init(void)
     spi_init(SPI0, &spi_init_struct);
     
     spi_enable(SPI0);
+}
+
+/*
+*   ݣʼSPI0DMA洢裬8λȼó߸ADC
+*   
+*   ֵ
+*/
+void mx_spi0_dma_init(void)
+{
+    //DMAṹ
+    dma_parameter_struct dma_init_struct;
+    
+    //ʹDMAʱ
+    rcu_periph_clock_enable(RCU_DMA);
+    
+    //DMAͨλ
+    dma_deinit(SPI0_DMA_CH);
+    
+    dma_struct_para_init(&dma_init_struct);
+    
+    dma_init_struct.periph_addr  = (uint32_t)(&SPI_DATA(SPI0));    //SPI0ݼĴ
+    dma_init_struct.periph_inc   = DMA_PERIPH_INCREASE_DISABLE;     //ַ
+    dma_init_struct.memory_addr  = 0;                               //ʱ
+    dma_init_struct.memory_inc   = DMA_MEMORY_INCREASE_ENABLE;      //洢ַ
+    dma_init_struct.periph_width = DMA_PERIPHERAL_WIDTH_8BIT;       //8λ
+    dma_init_struct.memory_width = DMA_MEMORY_WIDTH_8BIT;           //洢8λ
+    dma_init_struct.direction    = DMA_MEMORY_TO_PERIPHERAL;        //洢
+    dma_init_struct.number       = 0;                               //ʱ
+    dma_init_struct.priority     = DMA_PRIORITY_LOW;                //ȼ
+    dma_init(SPI0_DMA_CH, &dma_init_struct);
+    
+    dma_circulation_disable(SPI0_DMA_CH);
+    dma_memory_to_memory_disable(SPI0_DMA_CH);
+    
+    //ж
+    dma_interrupt_enable(SPI0_DMA_CH, DMA_CHXCTL_FTFIE);
+    nvic_irq_enable(DMA_Channel1_2_IRQn, 1U);
+    
+    //SPI0ͻʱDMAͨرʱѯͲӰ
+    spi_dma_enable(SPI0, SPI_DMA_TRANSMIT);
+}
+
+/*
+*   ݣлSPI0֡8λ֡16λ֡FF16ֻSPIرʱ޸
+*   size--SPI_FRAMESIZE_8BITSPI_FRAMESIZE_16BIT
+*   ֵ
+*/
+void spi0_frame_size(uint16_t size)
+{
+    if(size == spi0_frame)
+        return;
+    
+    spi0_flush();
+    spi_disable(SPI0);
+    spi_i2s_data_frame_format_config(SPI0, size);
+    spi_enable(SPI0);
+    spi0_frame = size;
+}
+
+/*
+*   ݣһ鴫
+*   
+*   ֵ
+*/
+static void spi0_dma_next(void)
+{
+    uint16_t num = (spi0_dma_left > SPI0_DMA_CHUNK) ? SPI0_DMA_CHUNK : (uint16_t)spi0_dma_left;
+    
+    dma_channel_disable(SPI0_DMA_CH);
+    dma_memory_address_config(SPI0_DMA_CH, (uint32_t)spi0_dma_src);
+    dma_transfer_number_config(SPI0_DMA_CH, num);
+    dma_channel_enable(SPI0_DMA_CH);
+    
+    spi0_dma_src  += (uint32_t)num * spi0_dma_step;
+    spi0_dma_left -= num;
+}
+
+/*
+*   ݣǰ֡䣬DMAλ֡һ
+*   src---Դַ
+*             num---֡
+*             inc---ԴַǷ
+*             done--ɻصΪNULL
+*   ֵ
+*/
+static void spi0_dma_start(const void *src, uint32_t num, uint8_t inc, spi_dma_callback done)
+{
+    uint8_t width = (spi0_frame == SPI_FRAMESIZE_16BIT) ? 2U : 1U;
+    
+    spi0_dma_wait();
+    if(num == 0)
+        return;
+    
+    spi0_dma_src  = (const uint8_t *)src;
+    spi0_dma_left = num;
+    spi0_dma_step = inc ? width : 0U;
+    spi0_dma_done = done;
+    spi0_dma_run  = 1;
+    
+    if(width == 2U)
+    {
+        dma_periph_width_config(SPI0_DMA_CH, DMA_PERIPHERAL_WIDTH_16BIT);
+        dma_memory_width_config(SPI0_DMA_CH, DMA_MEMORY_WIDTH_16BIT);
+    }
+    else
+    {
+        dma_periph_width_config(SPI0_DMA_CH, DMA_PERIPHERAL_WIDTH_8BIT);
+        dma_memory_width_config(SPI0_DMA_CH, DMA_MEMORY_WIDTH_8BIT);
+    }
+    if(inc)
+        dma_memory_increase_enable(SPI0_DMA_CH);
+    else
+        dma_memory_increase_disable(SPI0_DMA_CH);
+    spi0_dma_next();
+}
+
+/*
+*   ݣDMAһλأɺжûص
+*   buf--Դ16λ֡ʱΪ飬ǰܸд
+*             num--֡
+*             done-ɻصΪNULL
+*   ֵ
+*/
+void spi0_dma_send(const void *buf, uint32_t num, spi_dma_callback done)
+{
+    spi0_dma_start(buf, num, 1, done);
+}
+
+/*
+*   ݣDMAظͬһ̶֡Դַرմ洢
+*   value--֡ݣǰܸд
+*             num----֡
+*             done---ɻصΪNULL
+*   ֵ
+*/
+void spi0_dma_repeat(const void *value, uint32_t num, spi_dma_callback done)
+{
+    spi0_dma_start(value, num, 0, done);
+}
+
+/*
+*   ݣѯDMAǷ
+*   
+*   ֵ1--У0--
+*/
+uint8_t spi0_dma_busy(void)
+{
+    return spi0_dma_run;
+}
+
+/*
+*   ݣȴDMAͽһ֡Ƴ
+*   
+*   ֵ
+*/
+void spi0_dma_wait(void)
+{
+    while(spi0_dma_run);
+}
+
+/*
+*   ݣȴͻһ֡Ƴ֮лƬѡ/߻֡
+*   
+*   ֵ
+*/
+void spi0_flush(void)
+{
+    while(spi_i2s_flag_get(SPI0, SPI_FLAG_TBE) == RESET);
+    while(spi_i2s_flag_get(SPI0, SPI_FLAG_TRANS) == SET);
+}
+
+/*
+*   ݣDMAͨ12жϣͨ2ΪSPI0
+*   
+*   ֵ
+*/
+void DMA_Channel1_2_IRQHandler(void)
+{
+    spi_dma_callback done = NULL;
+    
+    if(dma_interrupt_flag_get(SPI0_DMA_CH, DMA_INT_FLAG_FTF))
+    {
+        dma_interrupt_flag_clear(SPI0_DMA_CH, DMA_INT_FLAG_G);
+        
+        if(spi0_dma_left > 0)
+        {
+            spi0_dma_next();
+            return;
+        }
+        
+        //һ֡дݼĴȴλͷƬѡ
+        dma_channel_disable(SPI0_DMA_CH);
+        spi0_flush();
+        
+        done = spi0_dma_done;
+        spi0_dma_done = NULL;
+        spi0_dma_run = 0;
+        if(done != NULL)
+            done();
+    }
 }
\ No newline at end of file
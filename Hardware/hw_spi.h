@@ -3,7 +3,19 @@
 
 #include "main.h"
 
+#define SPI0_DMA_CH     DMA_CH2     //SPI0_TXDMAͨ
+#define SPI0_DMA_CHUNK  0xFFFFU     //DMAδ֡
+
+typedef void (*spi_dma_callback)(void);
+
 void mx_spi0_init(void);
+void mx_spi0_dma_init(void);
+void spi0_frame_size(uint16_t size);
+void spi0_dma_send(const void *buf, uint32_t num, spi_dma_callback done);
+void spi0_dma_repeat(const void *value, uint32_t num, spi_dma_callback done);
+uint8_t spi0_dma_busy(void);
+void spi0_dma_wait(void);
+void spi0_flush(void);
 
 #endif
 
@@ -57,16 +57,14 @@ void mx_tim2_init(void)
     
     gpio_af_set(GPIOA, GPIO_AF_1, GPIO_PIN_6);	//Ϊù
     
-    nvic_irq_enable(TIMER2_IRQn, 1U);	//ʱжʹ
-    
     timer_deinit(TIMER2);	//λʱ
      
     timer_struct_para_init(&timer_initpara);	//ʱʼ
     
-    timer_initpara.prescaler         = 71;                  //ԤƵ
+    timer_initpara.prescaler         = 0;                   //ԤƵmx_tim2_mode_configƵʽ
     timer_initpara.alignedmode       = TIMER_COUNTER_EDGE;  //ض
     timer_initpara.counterdirection  = TIMER_COUNTER_UP;    //ϼ
-    timer_initpara.period            = 65535;               //
+    timer_initpara.period            = 65535;               //ڣPWMʱʾڳ16λ
     timer_initpara.clockdivision     = TIMER_CKDIV_DIV1;    //ʱӷƵ
     timer_init(TIMER2, &timer_initpara);                    //ʼ
     
@@ -76,15 +74,46 @@ void mx_tim2_init(void)
     timer_icinitpara.icselection = TIMER_IC_SELECTION_DIRECTTI;     //ͨģʽѡ
     timer_icinitpara.icprescaler = TIMER_IC_PSC_DIV1;               //ͨ벶ԤƵ
     timer_icinitpara.icfilter    = 0x00;                            //ͨ벶˲
-    timer_input_capture_config(TIMER2,TIMER_CH_0,&timer_icinitpara);
+    timer_input_pwm_capture_config(TIMER2,TIMER_CH_0,&timer_icinitpara);	//ͨ1ͬһ½
     
     timer_auto_reload_shadow_enable(TIMER2);	//ʹԶװֵ
     
-    timer_interrupt_flag_clear(TIMER2,TIMER_INT_FLAG_CH0);	//жϱ־λ
-    
-    timer_interrupt_enable(TIMER2,TIMER_INT_CH0);	//ʹܶʱͨж
+    mx_tim2_mode_config(TIM2_MODE_COUNT,0);	//բżʼƵȫ̲ʹöʱ2ж
     
-    timer_disable(TIMER2);	//ʱжʧ
+    timer_disable(TIMER2);	//ʱʧ
+}
+
+/*
+*   ݣлʱ2ʽ
+*   uint8_t mode -- TIM2_MODE_COUNTPA6Ϊʱ(ⲿʱģʽ0CI0FE0)
+*                             TIM2_MODE_PWMظλͨ0Ϊڣͨ1Ϊߵƽ
+*             uint16_t psc -- ԤƵբżʱΪ0ⲿʱͬԤƵ
+*   ֵ  
+*/
+void mx_tim2_mode_config(uint8_t mode, uint16_t psc)
+{
+    timer_slave_mode_select(TIMER2,TIMER_SLAVE_MODE_DISABLE);	//ָڲʱ
+    
+    timer_update_source_config(TIMER2,TIMER_UPDATE_SRC_GLOBAL);
+    
+    timer_prescaler_config(TIMER2,psc,TIMER_PSC_RELOAD_NOW);	//ԤƵͬʱ
+    
+    if(mode == TIM2_MODE_COUNT)
+    {
+        timer_external_trigger_as_external_clock_config(TIMER2,TIMER_SMCFG_TRGSEL_CI0FE0,TIMER_IC_POLARITY_RISING,0x00);
+        return;
+    }
+    
+    if(mode == TIM2_MODE_PWM)
+    {
+        timer_update_source_config(TIMER2,TIMER_UPDATE_SRC_REGULAR);	//λ־־ֻʾڳ16λ
+        
+        timer_input_trigger_source_select(TIMER2,TIMER_SMCFG_TRGSEL_CI0FE0);	//CI0Ϊλ
+        
+        timer_slave_mode_select(TIMER2,TIMER_SLAVE_MODE_RESTART);
+        
+        timer_flag_clear(TIMER2,TIMER_FLAG_UP | TIMER_FLAG_CH0 | TIMER_FLAG_CH1);
+    }
 }
 
 /*
@@ -144,4 +173,70 @@ void mx_tim14_init(void)
 	timer_primary_output_config(TIMER14, ENABLE);	//öʱΪҪͨʹ
 	
 	timer_disable(TIMER14);		//ʧܶʱ
-}
\ No newline at end of file
+}
+
+/*
+*   Function: Initialize advanced timer 0 as the ADC sample clock
+*   Parameters: None
+*   Return: None
+*   Note: CH1 compare event is routed to the ADC regular trigger (ADC_EXTTRIG_REGULAR_T0_CH1).
+*         CH0 captures the comparator output, timestamping trigger edges in the same time base.
+*         No pin is switched to AF, so nothing is driven externally.
+*/
+void mx_tim0_init(void)
+{
+	timer_oc_parameter_struct timer_ocinitpara;	/* Timer channel output parameter structure */
+
+	timer_ic_parameter_struct timer_icinitpara;	/* Timer channel input parameter structure */
+
+	timer_parameter_struct timer_initpara;		/* Timer initialization parameter structure */
+
+	rcu_periph_clock_enable(RCU_TIMER0);		/* Enable TIMER0 clock */
+
+	timer_deinit(TIMER0);	/* Reset TIMER0 */
+
+	timer_struct_para_init(&timer_initpara);	/* Initialize timer structure */
+
+	timer_initpara.prescaler         = 71;					/* 1MHz counter clock, overwritten by the timebase table */
+	timer_initpara.alignedmode       = TIMER_COUNTER_EDGE;	/* Edge aligned */
+	timer_initpara.counterdirection  = TIMER_COUNTER_UP;		/* Count up */
+	timer_initpara.period            = 49;					/* 50us sample period */
+	timer_initpara.clockdivision     = TIMER_CKDIV_DIV1;		/* Clock division */
+	timer_initpara.repetitioncounter = 0;					/* Repetition counter */
+	timer_init(TIMER0, &timer_initpara);
+
+	timer_channel_output_struct_para_init(&timer_ocinitpara);	/* Initialize channel output structure */
+
+	timer_ocinitpara.outputstate  = TIMER_CCX_ENABLE;			/* Channel output enable, required for the CH0 trigger event */
+	timer_ocinitpara.outputnstate = TIMER_CCXN_DISABLE;		    /* Complementary output disable */
+	timer_ocinitpara.ocpolarity   = TIMER_OC_POLARITY_HIGH;	    /* Output polarity high */
+	timer_ocinitpara.ocnpolarity  = TIMER_OCN_POLARITY_HIGH;    /* Complementary output polarity high */
+	timer_ocinitpara.ocidlestate  = TIMER_OC_IDLE_STATE_LOW;    /* Idle state low */
+	timer_ocinitpara.ocnidlestate = TIMER_OCN_IDLE_STATE_LOW;   /* Complementary idle state low */
+
+	timer_channel_output_config(TIMER0, TIMER_CH_1, &timer_ocinitpara);
+
+	timer_channel_output_pulse_value_config(TIMER0, TIMER_CH_1, 25);	/* Compare value, one ADC trigger per period */
+
+	timer_channel_output_mode_config(TIMER0, TIMER_CH_1, TIMER_OC_MODE_PWM0);
+
+	timer_channel_output_shadow_config(TIMER0, TIMER_CH_1, TIMER_OC_SHADOW_ENABLE);	/* Apply new compare value on update */
+
+	timer_channel_input_struct_para_init(&timer_icinitpara);	/* Initialize channel input structure */
+
+	timer_icinitpara.icpolarity  = TIMER_IC_POLARITY_RISING;		/* Comparator output rising edge */
+	timer_icinitpara.icselection = TIMER_IC_SELECTION_DIRECTTI;	/* CI0 is driven by the comparator */
+	timer_icinitpara.icprescaler = TIMER_IC_PSC_DIV1;			/* Capture every edge */
+	timer_icinitpara.icfilter    = 0x00;						/* No filter, comparator has hysteresis */
+	timer_input_capture_config(TIMER0, TIMER_CH_0, &timer_icinitpara);
+
+	timer_interrupt_flag_clear(TIMER0, TIMER_INT_FLAG_CH0);		/* Capture interrupt is enabled when armed */
+
+	nvic_irq_enable(TIMER0_Channel_IRQn, 0U);
+
+	timer_auto_reload_shadow_enable(TIMER0);	/* Apply new period on update */
+
+	timer_primary_output_config(TIMER0, ENABLE);	/* Advanced timer needs primary output enable */
+
+	timer_disable(TIMER0);	/* Started in main() once the DMA is registered */
+}
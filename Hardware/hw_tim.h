@@ -3,8 +3,13 @@
 
 #include "main.h"
 
+#define TIM2_MODE_COUNT   0x01		//PA6Ϊʱӣж
+#define TIM2_MODE_PWM     0x02		//PWM룬ظλж
+
 void mx_tim15_init(void);
 void mx_tim2_init(void);
+void mx_tim2_mode_config(uint8_t mode, uint16_t psc);
 void mx_tim14_init(void);
+void mx_tim0_init(void);
 
 #endif
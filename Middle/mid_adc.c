@@ -1,8 +1,425 @@
 #include "mid_adc.h"
+#include "hw_adc.h"
+#include "hw_cmp.h"
 #include "stdio.h"
 #include "string.h"
 
 static uint8_t adc_convert_bit = ADC_CONVERT_UN_FINSIH;
+static uint8_t adc_timebase = ADC_TIMEBASE_DEF;
+static __IO uint8_t adc_ready_half = 0;			/* Last completed half: 0 = first, 1 = second */
+static __IO uint16_t adc_half_seq = 0;			/* Completed half counter, detects overwrite while processing */
+static uint8_t adc_acq_mode = ADC_ACQ_NORMAL;		/* Acquisition mode */
+static uint8_t adc_sample_bits = 12;				/* Width of each DMA word in bits */
+static uint8_t adc_channel = ADC_CHANNEL_3;			/* Regular channel sampled by the TIMER0 clock */
+static uint8_t adc_clk = ADC_CLK_AHB_8M;			/* ADC clock profile in use */
+static uint16_t adc_wdg_mask = 0x0FFFU;				/* Watchdog threshold bits compared at the current resolution */
+
+static uint16_t *adc_ring = NULL;					/* Circular DMA buffer, ADC_NUM half-words */
+static uint8_t adc_ring_packed = 0;					/* Ring holds one byte per sample */
+static uint16_t adc_ring_num = ADC_NUM;				/* Ring length in samples */
+static uint16_t adc_ring_half = ADC_HALF_NUM;		/* Ping-pong half length in samples */
+static uint32_t adc_res = ADC_RESOLUTION_12B;		/* ADC resolution in use */
+static uint16_t adc_window[ADC_WINDOW_NUM];			/* Triggered record copied out of the ring */
+static __IO uint8_t adc_trig_state = ADC_TRIG_IDLE;	/* Trigger state */
+static __IO uint16_t adc_trig_pos = 0;				/* Ring index of the trigger sample */
+static uint16_t adc_trig_level = ADC_TRIG_LEVEL_DEF;	/* Trigger level */
+static uint16_t adc_trig_hyst = ADC_TRIG_HYST_DEF;	/* Trigger hysteresis */
+static uint8_t adc_trig_pct = ADC_TRIG_PCT_DEF;		/* Adaptive level, percent of the tracked swing */
+static uint16_t adc_trk_min = 0;					/* Tracked minimum of recent records, 12-bit */
+static uint16_t adc_trk_max = 0;					/* Tracked maximum of recent records, 12-bit */
+static uint8_t adc_trk_valid = 0;					/* Tracker holds a record */
+static uint16_t adc_trig_top = 0;					/* Runt upper threshold from the tracked swing, 0 = level + 4 hyst */
+static uint16_t adc_trig_pre = ADC_WINDOW_NUM / 2;	/* Samples shown before the trigger */
+static uint8_t adc_trig_source = ADC_TRIG_SRC_WDG;	/* Trigger source */
+static uint8_t adc_trig_mode = TRIG_MODE_RISE;		/* Trigger mode (TRIG_MODE_xxx) */
+static __IO uint8_t adc_trig_phase = 0;				/* Trigger edge position after the trigger sample, 1/256 sample */
+static uint32_t adc_conv_ns = ADC_CONV_NS;			/* Time from TIMER0 trigger to DMA write */
+static uint8_t adc_ets_fill[(ADC_WINDOW_NUM + 7) / 8];	/* Equivalent-time columns written since the last rearm */
+static uint8_t adc_ets_pass = 0;					/* Captures merged into the equivalent-time record */
+static uint16_t adc_sample_arr = 0;					/* TIMER0 reload in use */
+static uint16_t adc_window_min[ADC_WINDOW_NUM];		/* Peak-detect column minimum, adc_window holds the maximum */
+static uint16_t adc_pd_lo[ADC_PD_COLS];				/* Peak-detect column ring, minimum */
+static uint16_t adc_pd_hi[ADC_PD_COLS];				/* Peak-detect column ring, maximum */
+static uint16_t adc_pd_ratio = 0;					/* Raw samples per column, 0 = peak detect off */
+static uint16_t adc_pd_col = 0;						/* Closed columns, free running */
+static uint16_t adc_pd_cnt = 0;						/* Raw samples in the open column */
+static uint16_t adc_pd_min = 0;						/* Open column minimum */
+static uint16_t adc_pd_max = 0;						/* Open column maximum */
+static uint16_t adc_pd_trig_col = 0;				/* Column of the trigger sample */
+static uint8_t adc_pd_trig_valid = 0;				/* adc_pd_trig_col computed for this capture */
+static uint16_t adc_roll_rd = 0;					/* Roll: next ring index to read */
+static uint16_t adc_roll_col = 0;					/* Roll: next peak-detect column to read */
+static uint16_t adc_resume_seq = 0;					/* adc_half_seq when the ring was last restarted empty */
+
+static void adc_cmp_level_apply(void);
+static void adc_trigger_arm(void);
+static uint16_t adc_level_to_sample(uint16_t level);
+
+/*
+ * ADC clock profile: converter clock, sample time and resolution
+ */
+struct adc_clock
+{
+	rcu_adc_clock_enum clock;				/* ADC clock source */
+	uint32_t sample_time;					/* Regular channel sample time (ADC_SAMPLETIME_xxx) */
+	uint32_t resolution;					/* ADC_RESOLUTION_xxx */
+	uint8_t bits;							/* Result width */
+	uint16_t conv_ns;						/* (sample + resolution) cycles, trigger to DMA write */
+};
+
+/*
+ * Conversion = sample time + (resolution + 0.5) cycles
+ * IRC28M entries only serve the timebases the 8MHz clock cannot reach
+ */
+static const struct adc_clock adc_clock_tab[ADC_CLK_NUM] =
+{
+	{RCU_ADCCK_AHB_DIV9, ADC_SAMPLETIME_28POINT5, ADC_RESOLUTION_12B, 12, ADC_CONV_NS},	/* 41 cycles at 8MHz */
+	{RCU_ADCCK_IRC28M,   ADC_SAMPLETIME_55POINT5, ADC_RESOLUTION_12B, 12, 2429},		/* 68 cycles at 28MHz */
+	{RCU_ADCCK_IRC28M,   ADC_SAMPLETIME_28POINT5, ADC_RESOLUTION_12B, 12, 1465},		/* 41 cycles at 28MHz */
+	{RCU_ADCCK_IRC28M,   ADC_SAMPLETIME_7POINT5,  ADC_RESOLUTION_12B, 12,  715},		/* 20 cycles at 28MHz */
+	{RCU_ADCCK_IRC28M,   ADC_SAMPLETIME_1POINT5,  ADC_RESOLUTION_10B, 10,  429},		/* 12 cycles at 28MHz */
+};
+
+/*
+ * Timebase table, TIMER0 clock = 72MHz
+ * Sample interval = (psc + 1) * (arr + 1) / 72MHz, one division = ADC_DIV_SAMPLES samples
+ * Every entry stays above one conversion of its ADC clock profile
+ * High-res: ratio * 5.1us must fit in the sample interval, result = 12 + log2(ratio) - shift bits
+ * Peak detect: raw samples every 10us, at least 5 per column so a DMA half closes at most
+ * 100 columns and the column ring keeps a full window behind the newest half
+ */
+static const struct adc_timebase adc_timebase_tab[ADC_TIMEBASE_NUM] =
+{
+	{ 0,   35,     500, "5us",   0,                             ADC_OVERSAMPLING_SHIFT_NONE, 0,   0, ADC_CLK_28M_0US4},
+	{ 0,   71,    1000, "10us",  0,                             ADC_OVERSAMPLING_SHIFT_NONE, 0,   0, ADC_CLK_28M_0US7},
+	{ 0,  143,    2000, "20us",  0,                             ADC_OVERSAMPLING_SHIFT_NONE, 0,   0, ADC_CLK_28M_1US5},
+	{ 0,  359,    5000, "50us",  0,                             ADC_OVERSAMPLING_SHIFT_NONE, 0,   0, ADC_CLK_28M_2US5},
+	{71,    9,   10000, "100us", 0,                             ADC_OVERSAMPLING_SHIFT_NONE, 0,   0, ADC_CLK_AHB_8M},
+	{71,   19,   20000, "200us", ADC_OVERSAMPLING_RATIO_MUL2,   ADC_OVERSAMPLING_SHIFT_NONE, 1,   0, ADC_CLK_AHB_8M},
+	{71,   49,   50000, "500us", ADC_OVERSAMPLING_RATIO_MUL8,   ADC_OVERSAMPLING_SHIFT_1B,   2,   5, ADC_CLK_AHB_8M},
+	{71,   99,  100000, "1ms",   ADC_OVERSAMPLING_RATIO_MUL16,  ADC_OVERSAMPLING_SHIFT_1B,   3,  10, ADC_CLK_AHB_8M},
+	{71,  199,  200000, "2ms",   ADC_OVERSAMPLING_RATIO_MUL32,  ADC_OVERSAMPLING_SHIFT_1B,   4,  20, ADC_CLK_AHB_8M},
+	{71,  499,  500000, "5ms",   ADC_OVERSAMPLING_RATIO_MUL64,  ADC_OVERSAMPLING_SHIFT_2B,   4,  50, ADC_CLK_AHB_8M},
+	{71,  999, 1000000, "10ms",  ADC_OVERSAMPLING_RATIO_MUL128, ADC_OVERSAMPLING_SHIFT_3B,   4, 100, ADC_CLK_AHB_8M},
+	{71, 1999, 2000000, "20ms",  ADC_OVERSAMPLING_RATIO_MUL256, ADC_OVERSAMPLING_SHIFT_4B,   4, 200, ADC_CLK_AHB_8M},
+	{71, 4999, 5000000, "50ms",  ADC_OVERSAMPLING_RATIO_MUL256, ADC_OVERSAMPLING_SHIFT_4B,   4, 500, ADC_CLK_AHB_8M},
+};
+
+/*
+ * Apply the TIMER0 and ADC settings of the current timebase and acquisition mode
+ * TIMER0 reloads on its next update event
+ */
+static void adc_profile_apply(void)
+{
+	const struct adc_timebase *tb = &adc_timebase_tab[adc_timebase];
+	const struct adc_clock *ck = &adc_clock_tab[tb->clk];
+	uint16_t arr = tb->arr;
+	uint8_t packed = (adc_acq_mode == ADC_ACQ_PACK8);
+	uint32_t res = packed ? ADC_RESOLUTION_8B : ck->resolution;
+	uint8_t bits = packed ? 8U : ck->bits;
+
+	/* Clock and resolution only change between the IRC28M and 8MHz ranges or for packed mode */
+	if((tb->clk != adc_clk) || (res != adc_res))
+	{
+		mx_adc_clock_config(ck->clock, res);
+		adc_clk = tb->clk;
+		adc_res = res;
+	}
+	adc_regular_channel_config(0, adc_channel, ck->sample_time);
+	/* The watchdog compares the 12-bit left-aligned result, unused low bits must stay 0 */
+	adc_wdg_mask = (uint16_t)(0x0FFFU << (12U - bits)) & 0x0FFFU;
+
+	/* Packed mode stores the low byte of each 8-bit result, same buffer holds twice the samples */
+	if((packed != adc_ring_packed) && (adc_ring != NULL))
+	{
+		adc_ring_packed = packed;
+		adc_ring_num = packed ? (ADC_NUM * 2U) : ADC_NUM;
+		adc_ring_half = adc_ring_num / 2U;
+		mx_adc_dma_restart((uint32_t)adc_ring, adc_ring_num,
+		                   packed ? DMA_MEMORY_WIDTH_8BIT : DMA_MEMORY_WIDTH_16BIT);
+	}
+
+	adc_pd_ratio = 0;
+	if((adc_acq_mode == ADC_ACQ_PEAK) && (tb->pd_ratio > 0))
+	{
+		/* Raw samples at the fastest rate, reduced to one min/max pair per column */
+		adc_pd_ratio = tb->pd_ratio;
+		arr = ADC_PD_ARR;
+	}
+	adc_pd_cnt = 0;
+	adc_sample_arr = arr;
+
+	timer_prescaler_config(TIMER0, tb->psc, TIMER_PSC_RELOAD_UPDATE);
+	timer_autoreload_value_config(TIMER0, arr);
+	timer_channel_output_pulse_value_config(TIMER0, TIMER_CH_1, (arr + 1U) / 2U);
+
+	if((adc_acq_mode == ADC_ACQ_HIRES) && (tb->ovs_bits > 0))
+	{
+		mx_adc_oversample_config(ENABLE, tb->ovs_ratio, tb->ovs_shift);
+		adc_sample_bits = ck->bits + tb->ovs_bits;
+		/* OVSR code n means 2^(n+1) back-to-back conversions */
+		adc_conv_ns = (uint32_t)ck->conv_ns << (((uint32_t)tb->ovs_ratio >> 2) + 1U);
+	}
+	else
+	{
+		mx_adc_oversample_config(DISABLE, 0, ADC_OVERSAMPLING_SHIFT_NONE);
+		adc_sample_bits = bits;
+		/* 8-bit results are ready 4 cycles earlier, the 12-bit time stays an upper bound */
+		adc_conv_ns = ck->conv_ns;
+	}
+
+	/* The pending half may hold samples of the old width */
+	adc_convert_bit = ADC_CONVERT_UN_FINSIH;
+	adc_trigger_rearm();
+}
+
+/*
+ * Ring index of the newest sample written by DMA
+ */
+static uint16_t adc_ring_latest(void)
+{
+	uint16_t written = adc_ring_num - (uint16_t)dma_transfer_number_get(DMA_CH0);
+
+	return (written + adc_ring_num - 1U) % adc_ring_num;
+}
+
+/*
+ * The comparator edge is placed against the sample clock from the TIMER0 counter read in
+ * the interrupt, which only works while the interrupt latency stays below one sample period.
+ * The psc = 0 timebases sample every 36..360 ticks of 72MHz and keep the watchdog trigger
+ */
+static uint8_t adc_cmp_usable(void)
+{
+	return adc_timebase_tab[adc_timebase].psc != 0;
+}
+
+/*
+ * Read one ring sample, 16-bit or packed 8-bit
+ */
+static uint16_t adc_ring_get(uint16_t idx)
+{
+	if(adc_ring_packed)
+		return ((const uint8_t *)adc_ring)[idx];
+	return adc_ring[idx];
+}
+
+/*
+ * Copy num samples starting at a ring index into a 16-bit buffer
+ */
+static void adc_ring_copy(uint16_t *dst, uint16_t idx, uint16_t num)
+{
+	uint16_t i = 0;
+
+	for(i = 0; i < num; i++)
+	{
+		dst[i] = adc_ring_get(idx);
+		if(++idx >= adc_ring_num)
+			idx = 0;
+	}
+}
+
+/*
+ * Check whether an equivalent-time column was written since the last rearm
+ */
+static uint8_t adc_ets_filled(uint16_t col)
+{
+	return (adc_ets_fill[col >> 3] >> (col & 7U)) & 0x01U;
+}
+
+/*
+ * Equivalent-time merge of one capture
+ * Sample pos + k was taken (k - phase) sample intervals after the trigger edge, so it belongs
+ * in column pre + (k - phase) * ADC_ETS_FACTOR. The comparator edge is asynchronous to the
+ * sample clock, successive captures land at other phases and fill the columns in between.
+ * The record is handed out once every column is filled or after ADC_ETS_PASS_MAX captures,
+ * otherwise the trigger is armed again from here without waiting for the main loop.
+ */
+static void adc_ets_merge(void)
+{
+	int16_t k = 0, kmin = 0, kmax = 0, col = 0, off = 0;
+	uint16_t i = 0, idx = 0, since = 0, filled = 0, hold = 0;
+
+	off = (int16_t)(((uint16_t)adc_trig_phase * ADC_ETS_FACTOR + 128U) >> 8);
+	kmin = -(int16_t)(adc_trig_pre / ADC_ETS_FACTOR) - 1;
+	kmax = (int16_t)((ADC_WINDOW_NUM - 1U - adc_trig_pre + ADC_ETS_FACTOR) / ADC_ETS_FACTOR);
+
+	since = (adc_ring_latest() + adc_ring_num - adc_trig_pos) % adc_ring_num;
+	if(since < (uint16_t)kmax)
+		return;
+
+	for(k = kmin; k <= kmax; k++)
+	{
+		col = (int16_t)adc_trig_pre + k * ADC_ETS_FACTOR - off;
+		if((col < 0) || (col >= ADC_WINDOW_NUM))
+			continue;
+		idx = (uint16_t)((int16_t)adc_trig_pos + k + (int16_t)adc_ring_num) % adc_ring_num;
+		adc_window[col] = adc_ring_get(idx);
+		adc_ets_fill[col >> 3] |= (uint8_t)(1U << (col & 7));
+	}
+	adc_ets_pass++;
+
+	for(i = 0; i < ADC_WINDOW_NUM; i++)
+	{
+		if(adc_ets_filled(i))
+		{
+			if(filled == 0)
+				hold = adc_window[i];
+			filled++;
+		}
+	}
+	if((filled < ADC_WINDOW_NUM) && (adc_ets_pass < ADC_ETS_PASS_MAX))
+	{
+		adc_trigger_arm();
+		return;
+	}
+
+	/* Columns no capture reached repeat their left neighbour */
+	for(i = 0; i < ADC_WINDOW_NUM; i++)
+	{
+		if(adc_ets_filled(i))
+			hold = adc_window[i];
+		else
+			adc_window[i] = hold;
+	}
+	adc_trig_state = ADC_TRIG_READY;
+}
+
+/*
+ * Peak detect: fold one completed DMA half into min/max column pairs
+ * A column may span several halves, the open column carries over to the next call
+ */
+static void adc_peak_reduce(uint8_t half)
+{
+	uint16_t i = 0, val = 0, base = 0;
+
+	if((adc_pd_ratio == 0) || (adc_ring == NULL))
+		return;
+
+	base = half * adc_ring_half;
+	for(i = 0; i < adc_ring_half; i++)
+	{
+		val = adc_ring_get(base + i);
+		if(adc_pd_cnt == 0)
+		{
+			adc_pd_min = val;
+			adc_pd_max = val;
+		}
+		else if(val < adc_pd_min)
+		{
+			adc_pd_min = val;
+		}
+		else if(val > adc_pd_max)
+		{
+			adc_pd_max = val;
+		}
+
+		if(++adc_pd_cnt >= adc_pd_ratio)
+		{
+			adc_pd_lo[adc_pd_col & (ADC_PD_COLS - 1U)] = adc_pd_min;
+			adc_pd_hi[adc_pd_col & (ADC_PD_COLS - 1U)] = adc_pd_max;
+			adc_pd_col++;
+			adc_pd_cnt = 0;
+		}
+	}
+}
+
+/*
+ * Peak detect: copy ADC_WINDOW_NUM column pairs starting at a free running column index
+ */
+static void adc_peak_copy(uint16_t first)
+{
+	uint16_t i = 0, idx = 0;
+
+	for(i = 0; i < ADC_WINDOW_NUM; i++)
+	{
+		idx = (first + i) & (ADC_PD_COLS - 1U);
+		adc_window[i] = adc_pd_hi[idx];
+		adc_window_min[i] = adc_pd_lo[idx];
+	}
+}
+
+/*
+ * Peak detect: locate the trigger sample among the columns and copy the window once
+ * the post-trigger columns are closed
+ */
+static void adc_peak_collect(void)
+{
+	uint16_t start = 0;
+	int16_t dist = 0;
+	int16_t ratio = (int16_t)adc_pd_ratio;
+
+	if(!adc_pd_trig_valid)
+	{
+		/* Raw distance from the first sample of the open column, within one half either way */
+		start = ((adc_ready_half + 1U) * adc_ring_half + adc_ring_num - adc_pd_cnt) % adc_ring_num;
+		dist = (int16_t)((adc_trig_pos + adc_ring_num - start) % adc_ring_num);
+		if(dist >= (int16_t)adc_ring_half)
+			dist -= (int16_t)adc_ring_num;
+		adc_pd_trig_col = adc_pd_col + ((dist >= 0) ? (dist / ratio) : -((ratio - 1 - dist) / ratio));
+		adc_pd_trig_valid = 1;
+	}
+
+	if((int16_t)(adc_pd_col - adc_pd_trig_col) < (int16_t)(ADC_WINDOW_NUM - adc_trig_pre))
+		return;
+
+	adc_peak_copy(adc_pd_trig_col - adc_trig_pre);
+	adc_trig_state = ADC_TRIG_READY;
+}
+
+/*
+ * Software trigger modes: walk the half DMA just completed, the search state carries over
+ * from the previous half so pulses across the boundary are measured whole
+ */
+static void adc_trigger_search(uint8_t half)
+{
+	uint16_t base = half * adc_ring_half;
+	uint16_t pos = 0;
+
+	if((adc_trig_state != ADC_TRIG_ARMED) || (adc_trig_mode <= TRIG_MODE_FALL) ||
+	   (adc_trig_source != ADC_TRIG_SRC_WDG) || (adc_ring == NULL))
+		return;
+
+	if(adc_ring_packed)
+		pos = trigger_search8((const uint8_t *)adc_ring + base, adc_ring_half);
+	else
+		pos = trigger_search(adc_ring + base, adc_ring_half);
+	if(pos != TRIG_NONE)
+	{
+		adc_trig_pos = base + pos;
+		adc_trig_state = ADC_TRIG_FIRED;
+	}
+}
+
+/*
+ * Copy the pre/post trigger window out of the ring once enough post-trigger samples arrived
+ * Called from the DMA half/full interrupt, at most one half (500 samples) after the crossing,
+ * so the pre-trigger part is always still intact
+ */
+static void adc_trigger_collect(void)
+{
+	uint16_t since = 0;
+
+	if((adc_trig_state != ADC_TRIG_FIRED) || (adc_ring == NULL))
+		return;
+
+	if(adc_acq_mode == ADC_ACQ_ETS)
+	{
+		adc_ets_merge();
+		return;
+	}
+	if(adc_pd_ratio > 0)
+	{
+		adc_peak_collect();
+		return;
+	}
+
+	since = (adc_ring_latest() + adc_ring_num - adc_trig_pos) % adc_ring_num;
+	if(since < (ADC_WINDOW_NUM - adc_trig_pre - 1U))
+		return;
+
+	adc_ring_copy(adc_window, (adc_trig_pos + adc_ring_num - adc_trig_pre) % adc_ring_num, ADC_WINDOW_NUM);
+	adc_trig_state = ADC_TRIG_READY;
+}
 
 /*
  * Get single ADC conversion value
@@ -83,7 +500,8 @@ uint16_t Get_ADC_Average(uint16_t num)
  */
 void Set_ADC_Channel(uint8_t channel)
 {
-	adc_regular_channel_config(0, channel, ADC_SAMPLETIME_28POINT5);
+	adc_channel = channel;
+	adc_regular_channel_config(0, channel, adc_clock_tab[adc_clk].sample_time);
 }
 
 /*
@@ -93,10 +511,125 @@ void Set_ADC_Channel(uint8_t channel)
  */
 void DMA_Channel0_IRQHandler(void)
 {
+	/* Circular ping-pong: DMA keeps running, only report which half is stable */
+	if(dma_interrupt_flag_get(DMA_CH0, DMA_INT_FLAG_HTF)){
+		adc_ready_half = 0;
+		adc_half_seq++;
+		dma_interrupt_flag_clear(DMA_CH0, DMA_INT_FLAG_HTF);
+		adc_peak_reduce(0);
+		adc_trigger_search(0);
+	}
 	if(dma_interrupt_flag_get(DMA_CH0, DMA_INT_FLAG_FTF)){
+		adc_ready_half = 1;
+		adc_half_seq++;
+		dma_interrupt_flag_clear(DMA_CH0, DMA_INT_FLAG_FTF);
+		adc_peak_reduce(1);
+		adc_trigger_search(1);
+	}
+	dma_interrupt_flag_clear(DMA_CH0, DMA_INT_FLAG_G);
+
+	/* Auto frame: newest full window once the previous one was shown, unless a triggered one waits */
+	/* The equivalent-time record is built in the window and has no auto frames */
+	if((adc_convert_bit == ADC_CONVERT_UN_FINSIH) && (adc_trig_state != ADC_TRIG_READY) &&
+	   (adc_acq_mode != ADC_ACQ_ETS) && (adc_ring != NULL))
+	{
+		if(adc_pd_ratio > 0)
+			adc_peak_copy(adc_pd_col - ADC_WINDOW_NUM);
+		else
+			adc_ring_copy(adc_window, adc_ready_half * adc_ring_half + adc_ring_half - ADC_WINDOW_NUM, ADC_WINDOW_NUM);
 		adc_convert_bit = ADC_CONVERT_FINSIH;
-		dma_channel_disable(DMA_CH0);	//�ر�dma
-		dma_interrupt_flag_clear(DMA_CH0, DMA_INT_FLAG_G);	//����жϱ�־λ
+	}
+	adc_trigger_collect();
+}
+
+/*
+ * Analog watchdog interrupt: two-stage rising or falling edge trigger done in hardware
+ * Rising: stage 1 fires when the signal is below level - hysteresis, stage 2 when it rises above level
+ * Falling: stage 1 fires above level, stage 2 when it drops below level - hysteresis
+ * The watchdog compares every conversion on the signal channel, thresholds are 12-bit
+ */
+/*
+ * The watchdog flags the crossing sample but the interrupt reads the ring later, several
+ * samples later on the IRC28M timebases. Step back over the samples already past the
+ * threshold to the first of them, at most ADC_TRIG_SLACK samples
+ */
+static uint16_t adc_trigger_first(uint16_t pos)
+{
+	uint16_t level = adc_level_to_sample(adc_trig_level);
+	uint16_t low = adc_level_to_sample((adc_trig_level > adc_trig_hyst) ? (adc_trig_level - adc_trig_hyst) : 0);
+	uint16_t prev = 0, val = 0, i = 0;
+
+	for(i = 0; i < ADC_TRIG_SLACK; i++)
+	{
+		prev = (pos + adc_ring_num - 1U) % adc_ring_num;
+		val = adc_ring_get(prev);
+		if((adc_trig_mode == TRIG_MODE_FALL) ? (val >= low) : (val <= level))
+			break;
+		pos = prev;
+	}
+	return pos;
+}
+
+void ADC_CMP_IRQHandler(void)
+{
+	uint16_t low = (adc_trig_level > adc_trig_hyst) ? (adc_trig_level - adc_trig_hyst) : 0;
+
+	if(adc_interrupt_flag_get(ADC_INT_FLAG_WDE)){
+		if(adc_trig_state == ADC_TRIG_ARMING){
+			adc_trig_state = ADC_TRIG_ARMED;
+			if(adc_trig_mode == TRIG_MODE_FALL)
+				adc_watchdog_threshold_config(low & adc_wdg_mask, 4095U & adc_wdg_mask);
+			else
+				adc_watchdog_threshold_config(0U, adc_trig_level & adc_wdg_mask);
+		}
+		else if(adc_trig_state == ADC_TRIG_ARMED){
+			adc_trig_pos = adc_trigger_first(adc_ring_latest());
+			adc_trig_state = ADC_TRIG_FIRED;
+			adc_interrupt_disable(ADC_INT_WDE);
+		}
+		adc_interrupt_flag_clear(ADC_INT_FLAG_WDE);
+	}
+}
+
+/*
+ * TIMER0 CH0 capture interrupt: comparator trigger edge, timestamped in the sample clock
+ * The capture locates the edge inside its sample period, the counter read next to the DMA
+ * count locates the newest sample. A sample triggered less than one conversion time ago is
+ * not in the ring yet and one triggered after the edge is not the trigger sample, both are
+ * corrected by hand. Needs the latency below one sample period, see adc_cmp_usable().
+ */
+void TIMER0_Channel_IRQHandler(void)
+{
+	uint32_t psc = adc_timebase_tab[adc_timebase].psc;
+	uint32_t cap = 0, now = 0, period = 0, pulse = 0, elapsed = 0, since = 0;
+	uint16_t pos = 0;
+
+	if(SET == timer_interrupt_flag_get(TIMER0, TIMER_INT_FLAG_CH0))
+	{
+		cap = timer_channel_capture_value_register_read(TIMER0, TIMER_CH_0);
+		if(adc_trig_state == ADC_TRIG_ARMED)
+		{
+			/* Counter and newest sample from the same instant: no DMA write between the reads */
+			do
+			{
+				pos = adc_ring_latest();
+				now = timer_counter_read(TIMER0);
+			} while(pos != adc_ring_latest());
+
+			period = adc_sample_arr + 1U;
+			pulse = period / 2U;
+			elapsed = (cap + period - pulse) % period;		/* Ticks from the trigger sample to the edge */
+			since = (now + period - pulse) % period;		/* Ticks from the newest sample trigger to now */
+			if(since * (psc + 1U) * 1000U < adc_conv_ns * 72U)
+				pos = (pos + 1U) % adc_ring_num;
+			if((now + period - cap) % period > since)
+				pos = (pos + adc_ring_num - 1U) % adc_ring_num;
+			adc_trig_pos = pos;
+			adc_trig_phase = (uint8_t)((elapsed << 8) / period);
+			adc_trig_state = ADC_TRIG_FIRED;
+			timer_interrupt_disable(TIMER0, TIMER_INT_CH0);
+		}
+		timer_interrupt_flag_clear(TIMER0, TIMER_INT_FLAG_CH0);
 	}
 }
 
@@ -119,3 +652,577 @@ void set_adc_convert_value(uint8_t bit)
 {
 	adc_convert_bit = bit;
 }
+
+/*
+ * Select timebase, reloads the TIMER0 sample clock on its next update event
+ */
+void set_adc_timebase_value(uint8_t index)
+{
+	if(index >= ADC_TIMEBASE_NUM)
+		index = ADC_TIMEBASE_NUM - 1;
+
+	adc_timebase = index;
+	if((adc_trig_source == ADC_TRIG_SRC_CMP) && !adc_cmp_usable())
+		set_adc_trigger_source(ADC_TRIG_SRC_WDG);
+	adc_profile_apply();
+}
+
+/*
+ * Get current timebase index
+ */
+uint8_t get_adc_timebase_value(void)
+{
+	return adc_timebase;
+}
+
+/*
+ * Get current timebase entry
+ */
+const struct adc_timebase *get_adc_timebase_info(void)
+{
+	return &adc_timebase_tab[adc_timebase];
+}
+
+/*
+ * Get any timebase entry, index clamped to the table
+ */
+const struct adc_timebase *get_adc_timebase_entry(uint8_t index)
+{
+	if(index >= ADC_TIMEBASE_NUM)
+		index = ADC_TIMEBASE_NUM - 1;
+	return &adc_timebase_tab[index];
+}
+
+/*
+ * Get the half buffer that was completed last and is not being written by DMA
+ */
+uint8_t get_adc_ready_half(void)
+{
+	return adc_ready_half;
+}
+
+/*
+ * Get completed half counter, a difference of 2 or more means the half was refilled
+ */
+uint16_t get_adc_half_seq(void)
+{
+	return adc_half_seq;
+}
+
+/*
+ * Set acquisition mode (ADC_ACQ_xxx)
+ * Equivalent-time sampling needs the sub-sample phase, only the comparator trigger gives it,
+ * so it is skipped on the timebases without the comparator
+ */
+void set_adc_acq_mode(uint8_t mode)
+{
+	if((mode == ADC_ACQ_ETS) && !adc_cmp_usable())
+		mode++;
+	if(mode >= ADC_ACQ_MAX)
+		mode = ADC_ACQ_NORMAL;
+
+	adc_acq_mode = mode;
+	if((mode == ADC_ACQ_ETS) && (adc_trig_source != ADC_TRIG_SRC_CMP))
+		set_adc_trigger_source(ADC_TRIG_SRC_CMP);
+	adc_profile_apply();
+}
+
+/*
+ * Get acquisition mode
+ */
+uint8_t get_adc_acq_mode(void)
+{
+	return adc_acq_mode;
+}
+
+/*
+ * Get width of the samples currently delivered by DMA, 12..16 bits
+ */
+uint8_t get_adc_sample_bits(void)
+{
+	return adc_sample_bits;
+}
+
+/*
+ * Register the circular DMA buffer used for triggered capture
+ */
+void adc_capture_register(uint16_t *ring)
+{
+	adc_ring = ring;
+}
+
+/*
+ * Trigger level in 12-bit ADC units to the width of the samples in the ring
+ */
+static uint16_t adc_level_to_sample(uint16_t level)
+{
+	if(adc_sample_bits > 12)
+		return (uint16_t)(level << (adc_sample_bits - 12));
+	return level >> (12 - adc_sample_bits);
+}
+
+/*
+ * Runt upper threshold in 12-bit units: 7/8 of the tracked swing, or four hysteresis steps
+ * above a fixed level. A pulse has to clear the level by its hysteresis before it can be a runt
+ */
+static uint16_t adc_trigger_top(void)
+{
+	uint32_t top = (adc_trig_top != 0) ? adc_trig_top : (uint32_t)adc_trig_level + adc_trig_hyst * 4U;
+
+	if(top < (uint32_t)adc_trig_level + adc_trig_hyst + 1U)
+		top = (uint32_t)adc_trig_level + adc_trig_hyst + 1U;
+	return (top > 4095U) ? 4095U : (uint16_t)top;
+}
+
+/*
+ * Arm the trigger of the selected source and mode
+ */
+static void adc_trigger_arm(void)
+{
+	uint16_t low = 0;
+
+	adc_interrupt_disable(ADC_INT_WDE);
+	timer_interrupt_disable(TIMER0, TIMER_INT_CH0);
+	adc_trig_phase = 0;
+	adc_pd_trig_valid = 0;		/* The trigger column belongs to the previous trigger */
+
+	if(adc_trig_source == ADC_TRIG_SRC_CMP)
+	{
+		/* Comparator hysteresis replaces the arming stage, next rising edge fires */
+		adc_trig_state = ADC_TRIG_ARMED;
+		timer_interrupt_flag_clear(TIMER0, TIMER_INT_FLAG_CH0);
+		timer_interrupt_enable(TIMER0, TIMER_INT_CH0);
+		return;
+	}
+
+	low = (adc_trig_level > adc_trig_hyst) ? (adc_trig_level - adc_trig_hyst) : 0;
+	if(adc_trig_mode > TRIG_MODE_FALL)
+	{
+		/* Searched in the completed DMA halves, the state goes to ARMED last so the */
+		/* interrupt never walks a half configured */
+		adc_trig_state = ADC_TRIG_IDLE;
+		trigger_arm(adc_trig_mode, adc_level_to_sample(adc_trig_level), adc_level_to_sample(adc_trig_hyst),
+		            adc_level_to_sample(adc_trigger_top()),
+		            ADC_DIV_SAMPLES * ((adc_pd_ratio > 0) ? adc_pd_ratio : 1U));
+		adc_trig_state = ADC_TRIG_ARMED;
+		return;
+	}
+
+	/* Rising: below level - hyst, then above level. Falling: above level, then below level - hyst */
+	adc_trig_state = ADC_TRIG_ARMING;
+	if(adc_trig_mode == TRIG_MODE_FALL)
+		adc_watchdog_threshold_config(0U, adc_trig_level & adc_wdg_mask);
+	else
+		adc_watchdog_threshold_config(low & adc_wdg_mask, 4095U & adc_wdg_mask);
+	adc_interrupt_flag_clear(ADC_INT_FLAG_WDE);
+	adc_interrupt_enable(ADC_INT_WDE);
+}
+
+/*
+ * Arm the hardware trigger for the next capture, starts a new equivalent-time record
+ */
+void adc_trigger_rearm(void)
+{
+	adc_trig_state = ADC_TRIG_IDLE;
+	memset(adc_ets_fill, 0, sizeof(adc_ets_fill));
+	adc_ets_pass = 0;
+	adc_trigger_arm();
+}
+
+/*
+ * Get trigger state (ADC_TRIG_xxx)
+ */
+uint8_t get_adc_trigger_state(void)
+{
+	return adc_trig_state;
+}
+
+/*
+ * Get the sample window, 16-bit whatever the ring width
+ * Triggered record while the state is ADC_TRIG_READY, otherwise the auto frame flagged by ADC_CONVERT_FINSIH
+ */
+const uint16_t *get_adc_trigger_window(void)
+{
+	return adc_window;
+}
+
+/*
+ * Get the peak-detect column minimum of the window, adc_window holds the maximum
+ * Valid for triggered and auto frames while get_adc_peak_ratio() is not 0
+ */
+const uint16_t *get_adc_trigger_window_min(void)
+{
+	return adc_window_min;
+}
+
+/*
+ * Get raw samples per peak-detect column, 0 when the current profile does not peak detect
+ */
+uint16_t get_adc_peak_ratio(void)
+{
+	return adc_pd_ratio;
+}
+
+/*
+ * Reverse the ring samples in [lo, hi), 16-bit or packed 8-bit
+ */
+static void adc_ring_reverse(uint16_t lo, uint16_t hi)
+{
+	uint8_t *bytes = (uint8_t *)adc_ring;
+	uint16_t tmp = 0;
+
+	while(hi > lo + 1U)
+	{
+		hi--;
+		if(adc_ring_packed)
+		{
+			tmp = bytes[lo];
+			bytes[lo] = bytes[hi];
+			bytes[hi] = (uint8_t)tmp;
+		}
+		else
+		{
+			tmp = adc_ring[lo];
+			adc_ring[lo] = adc_ring[hi];
+			adc_ring[hi] = tmp;
+		}
+		lo++;
+	}
+}
+
+/*
+ * Check that the ring holds at least num samples taken since it was last restarted
+ */
+uint8_t adc_capture_ready(uint16_t num)
+{
+	if((uint16_t)(adc_half_seq - adc_resume_seq) >= 2U)
+		return 1;
+	return ((adc_ring_num - (uint16_t)dma_transfer_number_get(DMA_CH0)) >= num);
+}
+
+/*
+ * Stop sampling and line up the newest num samples (num <= ADC_NUM) at the start of the ring
+ * Returned oldest first as 16-bit values whatever the ring width, for processing in place.
+ * The ring is rotated with three reversals, no extra buffer. Sampling stays stopped until
+ * adc_capture_resume(), which restarts it on an empty ring.
+ */
+uint16_t *adc_capture_freeze(uint16_t num)
+{
+	const uint8_t *bytes = (const uint8_t *)adc_ring;
+	uint16_t first = 0;
+	uint32_t i = 0;
+
+	timer_disable(TIMER0);
+	/* Let the conversion started by the last trigger reach the ring, 4+ cycles per pass */
+	for(i = adc_conv_ns / 50U + 1U; i > 0; i--)
+		__NOP();
+
+	/* Rotate left so the oldest of the newest num samples lands at index 0 */
+	first = (adc_ring_latest() + 1U + adc_ring_num - num) % adc_ring_num;
+	adc_ring_reverse(0, first);
+	adc_ring_reverse(first, adc_ring_num);
+	adc_ring_reverse(0, adc_ring_num);
+
+	/* Widen packed bytes in place, last first so no byte is overwritten before it is read */
+	if(adc_ring_packed)
+	{
+		for(i = num; i > 0; i--)
+			adc_ring[i - 1U] = bytes[i - 1U];
+	}
+	return adc_ring;
+}
+
+/*
+ * Restart sampling on an empty ring after adc_capture_freeze()
+ * The update event loads a timebase selected meanwhile at once instead of after the old period
+ */
+void adc_capture_resume(void)
+{
+	mx_adc_dma_restart((uint32_t)adc_ring, adc_ring_num,
+	                   adc_ring_packed ? DMA_MEMORY_WIDTH_8BIT : DMA_MEMORY_WIDTH_16BIT);
+	adc_resume_seq = adc_half_seq;
+	adc_pd_cnt = 0;
+	adc_convert_bit = ADC_CONVERT_UN_FINSIH;
+	adc_trigger_rearm();
+	timer_event_software_generate(TIMER0, TIMER_EVENT_SRC_UPG);
+	timer_enable(TIMER0);
+}
+
+/*
+ * Get the interval between ring samples, faster than the column interval in peak detect
+ */
+uint32_t get_adc_ring_sample_ns(void)
+{
+	if(adc_pd_ratio > 0)
+		return adc_timebase_tab[adc_timebase].sample_ns / adc_pd_ratio;
+	return adc_timebase_tab[adc_timebase].sample_ns;
+}
+
+/*
+ * Roll: skip everything captured so far, the next read starts with new data
+ */
+void adc_roll_start(void)
+{
+	adc_roll_rd = (adc_ring_latest() + 1U) % adc_ring_num;
+	adc_roll_col = adc_pd_col;
+}
+
+/*
+ * Roll: copy the samples written since the previous call, oldest first
+ * With peak detect the closed column pairs are returned, otherwise hi and lo get the same sample.
+ * Returns the number of entries, at most max, the rest is left for the next call
+ */
+uint16_t adc_roll_read(uint16_t *hi, uint16_t *lo, uint16_t max)
+{
+	uint16_t i = 0, num = 0, idx = 0;
+
+	if(adc_ring == NULL)
+		return 0;
+
+	if(adc_pd_ratio > 0)
+	{
+		num = adc_pd_col - adc_roll_col;
+		if(num > ADC_PD_COLS / 2U)
+		{
+			/* Fell behind the column ring, resume with the newest columns */
+			adc_roll_col = adc_pd_col - max;
+			num = max;
+		}
+		if(num > max)
+			num = max;
+		for(i = 0; i < num; i++)
+		{
+			idx = adc_roll_col & (ADC_PD_COLS - 1U);
+			hi[i] = adc_pd_hi[idx];
+			lo[i] = adc_pd_lo[idx];
+			adc_roll_col++;
+		}
+		return num;
+	}
+
+	num = (adc_ring_latest() + 1U + adc_ring_num - adc_roll_rd) % adc_ring_num;
+	if(num > max)
+		num = max;
+	adc_ring_copy(hi, adc_roll_rd, num);
+	for(i = 0; i < num; i++)
+	{
+		lo[i] = hi[i];
+	}
+	adc_roll_rd = (adc_roll_rd + num) % adc_ring_num;
+	return num;
+}
+
+/*
+ * Set trigger level and hysteresis in 12-bit ADC units, takes effect on the next rearm
+ */
+void set_adc_trigger_level(uint16_t level, uint16_t hyst)
+{
+	if(level > 4095U)
+		level = 4095U;
+	adc_trig_level = level;
+	adc_trig_hyst = hyst;
+	adc_trig_top = 0;
+	adc_trk_valid = 0;		/* Tracking restarts from the next record */
+	if(adc_trig_source == ADC_TRIG_SRC_CMP)
+		adc_cmp_level_apply();
+}
+
+/*
+ * Get trigger level in 12-bit ADC units
+ */
+uint16_t get_adc_trigger_level(void)
+{
+	return adc_trig_level;
+}
+
+/*
+ * Adaptive level: follow the swing of recent records, min/max in sample units of the record
+ * New extremes are taken at once, a shrinking swing is followed by 1/4 of the gap per record.
+ * The level sits at adc_trig_pct of the swing with an eighth of it as hysteresis, so noise
+ * does not retrigger. A swing under ADC_TRIG_TRACK_MIN is noise and keeps the last level.
+ * A trigger still waiting with the old level is armed again so a level that missed the
+ * signal does not leave it stuck.
+ */
+void adc_trigger_track(uint16_t min, uint16_t max)
+{
+	uint16_t span = 0, level = 0;
+	uint32_t primask = 0;
+
+	if(adc_sample_bits > 12)
+	{
+		min >>= (adc_sample_bits - 12);
+		max >>= (adc_sample_bits - 12);
+	}
+	else
+	{
+		min <<= (12 - adc_sample_bits);
+		max <<= (12 - adc_sample_bits);
+	}
+
+	if(!adc_trk_valid)
+	{
+		adc_trk_min = min;
+		adc_trk_max = max;
+		adc_trk_valid = 1;
+	}
+	else
+	{
+		if(min < adc_trk_min)
+			adc_trk_min = min;
+		else
+			adc_trk_min += (min - adc_trk_min) / 4U;
+		if(max > adc_trk_max)
+			adc_trk_max = max;
+		else
+			adc_trk_max -= (adc_trk_max - max) / 4U;
+	}
+
+	span = adc_trk_max - adc_trk_min;
+	if(span < ADC_TRIG_TRACK_MIN)
+		return;
+	adc_trig_top = adc_trk_max - span / 8U;		/* Runts fall back below 7/8 of the swing */
+	level = adc_trk_min + (uint16_t)(((uint32_t)span * adc_trig_pct) / 100U);
+	/* Small moves keep the armed trigger, arming again loses the wait for the low level */
+	if((level > adc_trig_level + adc_trig_hyst / 2U) || (level + adc_trig_hyst / 2U < adc_trig_level))
+	{
+		/* A trigger firing between the state test and the re-arm would be lost */
+		primask = __get_PRIMASK();
+		__disable_irq();
+		adc_trig_level = level;
+		adc_trig_hyst = span / 8U;
+		if(adc_trig_source == ADC_TRIG_SRC_CMP)
+			adc_cmp_level_apply();
+		if((adc_trig_state == ADC_TRIG_ARMING) || (adc_trig_state == ADC_TRIG_ARMED))
+			adc_trigger_arm();
+		__set_PRIMASK(primask);
+	}
+}
+
+/*
+ * Set adaptive trigger level position, percent of the tracked swing (20..80)
+ * The arming level sits an eighth of the swing lower and must stay above the minimum
+ */
+void set_adc_trigger_percent(uint8_t pct)
+{
+	if(pct < 20U)
+		pct = 20U;
+	if(pct > 80U)
+		pct = 80U;
+	adc_trig_pct = pct;
+	adc_trk_valid = 0;
+}
+
+/*
+ * Get adaptive trigger level position in percent
+ */
+uint8_t get_adc_trigger_percent(void)
+{
+	return adc_trig_pct;
+}
+
+/*
+ * Set number of samples shown before the trigger point
+ */
+void set_adc_trigger_pre(uint16_t pre)
+{
+	if(pre >= ADC_WINDOW_NUM)
+		pre = ADC_WINDOW_NUM - 1;
+	adc_trig_pre = pre;
+	adc_trigger_rearm();
+}
+
+/*
+ * Get number of samples shown before the trigger point
+ */
+uint16_t get_adc_trigger_pre(void)
+{
+	return adc_trig_pre;
+}
+
+/*
+ * Nearest comparator threshold to the trigger level
+ * Vrefint fractions assuming 1.2V Vrefint and 3.3V VDDA: 1489 counts * n / 4
+ */
+static void adc_cmp_level_apply(void)
+{
+	inverting_input_enum level = CMP_1_4VREFINT;
+
+	if(adc_trig_level >= 1303U)
+		level = CMP_VREFINT;
+	else if(adc_trig_level >= 931U)
+		level = CMP_3_4VREFINT;
+	else if(adc_trig_level >= 558U)
+		level = CMP_1_2VREFINT;
+
+	mx_cmp_level_config(level);
+}
+
+/*
+ * Select trigger source (ADC_TRIG_SRC_xxx)
+ * The comparator falls back to a rising watchdog trigger on the psc = 0 timebases
+ */
+void set_adc_trigger_source(uint8_t source)
+{
+	if((source == ADC_TRIG_SRC_CMP) && !adc_cmp_usable())
+	{
+		source = ADC_TRIG_SRC_WDG;
+		adc_trig_mode = TRIG_MODE_RISE;
+	}
+	adc_trig_source = source;
+	if(source == ADC_TRIG_SRC_CMP)
+	{
+		/* The comparator output only timestamps rising edges */
+		adc_trig_mode = TRIG_MODE_RISE;
+		adc_cmp_level_apply();
+		cmp_enable();
+	}
+	else
+	{
+		cmp_disable();
+		if(adc_acq_mode == ADC_ACQ_ETS)
+			adc_acq_mode = ADC_ACQ_NORMAL;
+	}
+	adc_trigger_rearm();
+}
+
+/*
+ * Get trigger source
+ */
+uint8_t get_adc_trigger_source(void)
+{
+	return adc_trig_source;
+}
+
+/*
+ * Select trigger mode (TRIG_MODE_xxx)
+ * Rising and falling edges run on the analog watchdog, the other modes are searched in
+ * software and need the watchdog source, which drops the comparator
+ */
+void set_adc_trigger_mode(uint8_t mode)
+{
+	if(mode >= TRIG_MODE_MAX)
+		mode = TRIG_MODE_RISE;
+
+	adc_trig_mode = mode;
+	if((mode != TRIG_MODE_RISE) && (adc_trig_source == ADC_TRIG_SRC_CMP))
+		set_adc_trigger_source(ADC_TRIG_SRC_WDG);
+	else
+		adc_trigger_rearm();
+}
+
+/*
+ * Get trigger mode
+ */
+uint8_t get_adc_trigger_mode(void)
+{
+	return adc_trig_mode;
+}
+
+/*
+ * Get trigger edge position after the trigger sample in 1/256 of a sample interval
+ * Always 0 for the watchdog source, which only resolves whole samples
+ */
+uint8_t get_adc_trigger_phase(void)
+{
+	return adc_trig_phase;
+}
@@ -2,15 +2,110 @@
 #define __MID_ADC_H
 
 #include "main.h"
+#include "mid_trigger.h"
 
 #define ADC_CONVERT_FINSIH    	0x01	//adcɼ	
 #define ADC_CONVERT_UN_FINSIH	0x02	//adcɼδ
 #define ADC_NUM 1000					//adcɼ
+#define ADC_HALF_NUM (ADC_NUM / 2)			/* Ping-pong half buffer length */
+
+#define ADC_TIMEBASE_NUM 13					/* Number of selectable timebases */
+#define ADC_TIMEBASE_DEF 6					/* Default timebase index (500us/div) */
+#define ADC_DIV_SAMPLES  10					/* Samples (screen columns) per division */
+
+#define ADC_ACQ_NORMAL   0x00				/* 12-bit samples */
+#define ADC_ACQ_HIRES    0x01				/* Hardware oversampling on slow timebases */
+#define ADC_ACQ_ETS      0x02				/* Equivalent-time sampling of repetitive signals */
+#define ADC_ACQ_PEAK     0x03				/* Peak detect: min/max of fast raw samples per column */
+#define ADC_ACQ_PACK8    0x04				/* 8-bit samples, byte-wide DMA, twice the ring depth */
+#define ADC_ACQ_MAX      0x05
+
+#define ADC_ETS_FACTOR   10					/* Equivalent-time columns per sample, matches 1us capture ticks at 100us/div */
+#define ADC_ETS_PASS_MAX 64					/* Captures merged before an incomplete record is shown */
+
+#define ADC_PD_ARR       9					/* TIMER0 reload for the 10us peak-detect raw clock */
+#define ADC_PD_COLS      256				/* Peak-detect column ring, power of two */
+
+#define ADC_ROLL_TB_MIN  10					/* First timebase index that can roll (10ms/div) */
+
+#define ADC_WINDOW_NUM   155				/* Triggered record length (one screen) */
+#define ADC_TRIG_LEVEL_DEF 2048				/* Default trigger level, 12-bit ADC units */
+#define ADC_TRIG_HYST_DEF  64				/* Default trigger hysteresis, 12-bit ADC units */
+#define ADC_TRIG_PCT_DEF   50				/* Adaptive trigger level, percent of the tracked swing */
+#define ADC_TRIG_TRACK_MIN 64				/* Smallest tracked swing the level follows, 12-bit ADC units */
+#define ADC_TRIG_SLACK     8				/* Samples the watchdog interrupt may read past the crossing */
+
+#define ADC_TRIG_IDLE    0x00				/* Trigger disarmed */
+#define ADC_TRIG_ARMING  0x01				/* Waiting for the signal to drop below level - hysteresis */
+#define ADC_TRIG_ARMED   0x02				/* Waiting for the signal to rise above level */
+#define ADC_TRIG_FIRED   0x03				/* Crossing latched, post-trigger samples filling */
+#define ADC_TRIG_READY   0x04				/* Window copied out of the ring */
+
+#define ADC_TRIG_SRC_WDG 0x00				/* ADC analog watchdog on the converted samples */
+#define ADC_TRIG_SRC_CMP 0x01				/* Comparator on PA1, timestamped by TIMER0 CH0 capture */
+
+#define ADC_CONV_NS      5125				/* One conversion: (28.5 + 12.5) cycles at 8MHz */
+
+#define ADC_CLK_AHB_8M   0x00				/* AHB/9 = 8MHz, 28.5 cycles sampling, 12-bit */
+#define ADC_CLK_28M_2US5 0x01				/* IRC28M, 55.5 cycles sampling, 12-bit */
+#define ADC_CLK_28M_1US5 0x02				/* IRC28M, 28.5 cycles sampling, 12-bit */
+#define ADC_CLK_28M_0US7 0x03				/* IRC28M, 7.5 cycles sampling, 12-bit */
+#define ADC_CLK_28M_0US4 0x04				/* IRC28M, 1.5 cycles sampling, 10-bit */
+#define ADC_CLK_NUM      0x05
+
+/*
+ * Timebase entry: TIMER0 reload values pacing the ADC and the resulting sample interval
+ */
+struct adc_timebase
+{
+	uint16_t psc;							/* TIMER0 prescaler */
+	uint16_t arr;							/* TIMER0 auto-reload value */
+	uint32_t sample_ns;						/* Sample interval in ns */
+	const char *label;						/* Time per division */
+	uint8_t ovs_ratio;						/* High-res oversampling ratio (ADC_OVERSAMPLING_RATIO_MULx) */
+	uint16_t ovs_shift;						/* High-res oversampling shift (ADC_OVERSAMPLING_SHIFT_xB) */
+	uint8_t ovs_bits;						/* Extra result bits over 12 in high-res mode, 0 = not available */
+	uint16_t pd_ratio;						/* Raw samples per column in peak-detect mode, 0 = not available */
+	uint8_t clk;							/* ADC clock profile (ADC_CLK_xxx) */
+};
 
 void get_adc_value_point(uint16_t *addr);
 void Set_ADC_Channel(uint8_t channel);
 uint16_t Get_ADC_Average(uint16_t num);
 uint8_t get_adc_convert_value(void);
 void set_adc_convert_value(uint8_t bit);
+void set_adc_timebase_value(uint8_t index);
+uint8_t get_adc_timebase_value(void);
+const struct adc_timebase *get_adc_timebase_info(void);
+const struct adc_timebase *get_adc_timebase_entry(uint8_t index);
+uint8_t get_adc_ready_half(void);
+uint16_t get_adc_half_seq(void);
+void set_adc_acq_mode(uint8_t mode);
+uint8_t get_adc_acq_mode(void);
+uint8_t get_adc_sample_bits(void);
+void adc_capture_register(uint16_t *ring);
+uint8_t adc_capture_ready(uint16_t num);
+uint16_t *adc_capture_freeze(uint16_t num);
+void adc_capture_resume(void);
+uint32_t get_adc_ring_sample_ns(void);
+void adc_trigger_rearm(void);
+uint8_t get_adc_trigger_state(void);
+const uint16_t *get_adc_trigger_window(void);
+const uint16_t *get_adc_trigger_window_min(void);
+uint16_t get_adc_peak_ratio(void);
+void adc_roll_start(void);
+uint16_t adc_roll_read(uint16_t *hi, uint16_t *lo, uint16_t max);
+void set_adc_trigger_level(uint16_t level, uint16_t hyst);
+uint16_t get_adc_trigger_level(void);
+void adc_trigger_track(uint16_t min, uint16_t max);
+void set_adc_trigger_percent(uint8_t pct);
+uint8_t get_adc_trigger_percent(void);
+void set_adc_trigger_pre(uint16_t pre);
+uint16_t get_adc_trigger_pre(void);
+void set_adc_trigger_source(uint8_t source);
+void set_adc_trigger_mode(uint8_t mode);
+uint8_t get_adc_trigger_mode(void);
+uint8_t get_adc_trigger_source(void);
+uint8_t get_adc_trigger_phase(void);
 
 #endif
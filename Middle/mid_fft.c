@@ -0,0 +1,349 @@
+#include "mid_fft.h"
+
+#define FFT_M          (FFT_N / 2)			/* Complex points, two real samples each */
+#define FFT_M_BITS     8					/* log2(FFT_M) */
+
+/* sin(2*pi*i/FFT_N) for the first quarter wave, Q15 */
+static const int16_t fft_sin_tab[FFT_N / 4 + 1] =
+{
+	    0,   402,   804,  1206,  1608,  2009,  2411,  2811,
+	 3212,  3612,  4011,  4410,  4808,  5205,  5602,  5998,
+	 6393,  6787,  7180,  7571,  7962,  8351,  8740,  9127,
+	 9512,  9896, 10279, 10660, 11039, 11417, 11793, 12167,
+	12540, 12910, 13279, 13646, 14010, 14373, 14733, 15091,
+	15447, 15800, 16151, 16500, 16846, 17190, 17531, 17869,
+	18205, 18538, 18868, 19195, 19520, 19841, 20160, 20475,
+	20788, 21097, 21403, 21706, 22006, 22302, 22595, 22884,
+	23170, 23453, 23732, 24008, 24279, 24548, 24812, 25073,
+	25330, 25583, 25833, 26078, 26320, 26557, 26791, 27020,
+	27246, 27467, 27684, 27897, 28106, 28311, 28511, 28707,
+	28899, 29086, 29269, 29448, 29622, 29792, 29957, 30118,
+	30274, 30425, 30572, 30715, 30853, 30986, 31114, 31238,
+	31357, 31471, 31581, 31686, 31786, 31881, 31972, 32058,
+	32138, 32214, 32286, 32352, 32413, 32470, 32522, 32568,
+	32610, 32647, 32679, 32706, 32729, 32746, 32758, 32766,
+	32767
+};
+
+/*
+ * sin(2*pi*k/FFT_N), Q15
+ */
+static int32_t fft_sin(uint16_t k)
+{
+	k &= FFT_N - 1U;
+	if(k <= FFT_N / 4U)
+		return fft_sin_tab[k];
+	if(k <= FFT_N / 2U)
+		return fft_sin_tab[FFT_N / 2U - k];
+	if(k <= FFT_N * 3U / 4U)
+		return -fft_sin_tab[k - FFT_N / 2U];
+	return -fft_sin_tab[FFT_N - k];
+}
+
+/*
+ * cos(2*pi*k/FFT_N), Q15
+ */
+static int32_t fft_cos(uint16_t k)
+{
+	return fft_sin(k + FFT_N / 4U);
+}
+
+/*
+ * Power to level in 0.1dB, log2 from the leading bit and a linear mantissa (error below 0.3dB)
+ */
+static uint16_t fft_level(uint32_t power)
+{
+	uint32_t n = 31;
+	uint32_t mant = 0;
+
+	if(power == 0)
+		return 0;
+	while((power & (1UL << n)) == 0)
+		n--;
+	mant = (n >= 8U) ? (power >> (n - 8U)) : (power << (8U - n));
+	/* 10 * log10(2) * 10 / 256 in Q16 */
+	return (uint16_t)((((n << 8) | (mant & 0xFFU)) * 7706UL) >> 16);
+}
+
+/*
+ * Magnitude level of one bin, 0.1dB
+ */
+static uint16_t fft_bin_level(int32_t re, int32_t im)
+{
+	return fft_level((uint32_t)(re * re) + (uint32_t)(im * im));
+}
+
+/*
+ * In-place transform of FFT_N real samples
+ * buf holds unsigned samples of the given width on entry and FFT_BINS levels in 0.1dB on return.
+ * The real samples are packed as FFT_M complex points (even = re, odd = im), transformed by a
+ * radix-2 FFT that halves every stage so int16 never overflows, then split into the real spectrum.
+ * A full-scale sine reads FFT_LEVEL_FS, minus FFT_HANN_GAIN with the Hann window.
+ * Cost: 1024 butterflies plus 256 split steps and levels, estimated from the operation count at
+ * about 80k cycles (~1.1ms at 72MHz). Tools/fft_bench times this file on the host per window.
+ */
+void fft_run(uint16_t *buf, uint8_t bits, uint8_t window)
+{
+	int16_t *x = (int16_t *)buf;
+	uint32_t sum = 0;
+	uint16_t i = 0, j = 0, k = 0, len = 0, half = 0, step = 0, rev = 0;
+	int32_t val = 0, mean = 0, wr = 0, wi = 0, tr = 0, ti = 0;
+	int32_t zr = 0, zi = 0, cr = 0, ci = 0, er = 0, ei = 0, or_ = 0, oi = 0;
+
+	/* Remove DC and scale to +-16384 so a complex point stays below 32768 */
+	for(i = 0; i < FFT_N; i++)
+		sum += buf[i];
+	mean = (int32_t)(sum / FFT_N);
+	for(i = 0; i < FFT_N; i++)
+	{
+		val = (int32_t)buf[i] - mean;
+		val = (bits <= 15U) ? (val << (15U - bits)) : (val >> (bits - 15U));
+		if(window == FFT_WIN_HANN)
+			val = (val * ((32768 - fft_cos(i)) >> 1)) >> 15;
+		x[i] = (int16_t)val;
+	}
+
+	/* Bit-reversed order of the complex points */
+	for(i = 0; i < FFT_M; i++)
+	{
+		rev = 0;
+		for(j = 0; j < FFT_M_BITS; j++)
+			rev |= ((i >> j) & 1U) << (FFT_M_BITS - 1U - j);
+		if(rev > i)
+		{
+			val = x[2 * i];
+			x[2 * i] = x[2 * rev];
+			x[2 * rev] = (int16_t)val;
+			val = x[2 * i + 1];
+			x[2 * i + 1] = x[2 * rev + 1];
+			x[2 * rev + 1] = (int16_t)val;
+		}
+	}
+
+	/* Radix-2 decimation in time, every stage scaled by 1/2 */
+	for(len = 2; len <= FFT_M; len <<= 1)
+	{
+		half = len >> 1;
+		step = FFT_N / len;
+		for(j = 0; j < half; j++)
+		{
+			wr = fft_cos(j * step);
+			wi = -fft_sin(j * step);
+			for(i = j; i < FFT_M; i += len)
+			{
+				k = i + half;
+				tr = (wr * x[2 * k] - wi * x[2 * k + 1]) >> 15;
+				ti = (wr * x[2 * k + 1] + wi * x[2 * k]) >> 15;
+				x[2 * k] = (int16_t)((x[2 * i] - tr) >> 1);
+				x[2 * k + 1] = (int16_t)((x[2 * i + 1] - ti) >> 1);
+				x[2 * i] = (int16_t)((x[2 * i] + tr) >> 1);
+				x[2 * i + 1] = (int16_t)((x[2 * i + 1] + ti) >> 1);
+			}
+		}
+	}
+
+	/* Split into the real spectrum, bins k and FFT_M - k come from the same two points */
+	/* Each level is written over the real part of its own point, compacted afterwards */
+	zr = x[0];
+	zi = x[1];
+	buf[0] = fft_bin_level((zr + zi) >> 1, 0);
+	for(k = 1; k <= FFT_M / 2U; k++)
+	{
+		zr = x[2 * k];
+		zi = x[2 * k + 1];
+		cr = x[2 * (FFT_M - k)];
+		ci = -x[2 * (FFT_M - k) + 1];
+		er = (zr + cr) >> 1;
+		ei = (zi + ci) >> 1;
+		or_ = (zi - ci) >> 1;
+		oi = (cr - zr) >> 1;
+		wr = fft_cos(k);
+		wi = -fft_sin(k);
+		tr = (wr * or_ - wi * oi) >> 15;
+		ti = (wr * oi + wi * or_) >> 15;
+		buf[2 * k] = fft_bin_level((er + tr) >> 1, (ei + ti) >> 1);
+		if(k != FFT_M / 2U)
+			buf[2 * (FFT_M - k)] = fft_bin_level((er - tr) >> 1, (ti - ei) >> 1);
+	}
+	for(k = 1; k < FFT_BINS; k++)
+		buf[k] = buf[2 * k];
+}
+
+/*
+ * Strongest bin above DC
+ */
+uint16_t fft_peak_bin(const uint16_t *level)
+{
+	uint16_t k = 0, peak = 1;
+
+	for(k = 2; k < FFT_BINS - 1U; k++)
+	{
+		if(level[k] > level[peak])
+			peak = k;
+	}
+	return peak;
+}
+
+/*
+ * Frequency of a bin in 0.01Hz, refined by a parabola through the levels of its neighbours
+ */
+uint32_t fft_peak_freq(const uint16_t *level, uint16_t bin, uint32_t sample_ns)
+{
+	int32_t a = 0, b = 0, c = 0, den = 0, delta = 0;
+
+	if((bin == 0) || (bin >= FFT_BINS - 1U) || (sample_ns == 0))
+		return 0;
+
+	a = level[bin - 1];
+	b = level[bin];
+	c = level[bin + 1];
+	den = a - 2 * b + c;
+	if(den < 0)
+		delta = ((a - c) * 128) / den;		/* Q8, within +-0.5 bin */
+
+	/* f = (bin + delta) / (FFT_N * sample_ns) */
+	return (uint32_t)(((uint64_t)(((int32_t)bin << 8) + delta) * 100000000000ULL) /
+	                  ((uint64_t)sample_ns * FFT_N * 256U));
+}
+
+/*
+ * Integer square root of a 64-bit value
+ */
+static uint32_t goertzel_isqrt(uint64_t val)
+{
+	uint64_t res = 0, bit = 1ULL << 62;
+
+	while(bit > val)
+		bit >>= 2;
+	while(bit != 0)
+	{
+		if(val >= res + bit)
+		{
+			val -= res + bit;
+			res = (res >> 1) + bit;
+		}
+		else
+		{
+			res >>= 1;
+		}
+		bit >>= 2;
+	}
+	return (uint32_t)res;
+}
+
+/*
+ * Record length holding a whole number of periods, as many as fit in max samples
+ * A whole number of periods keeps the leakage between harmonics low without a window.
+ * Returns 0 when not even one period fits or the frequency is unknown
+ */
+uint16_t goertzel_record_len(uint32_t freq_chz, uint32_t sample_ns, uint16_t max)
+{
+	uint64_t period_q8 = 0;
+	uint32_t cycles = 0;
+
+	if((freq_chz == 0) || (sample_ns == 0))
+		return 0;
+
+	/* Samples per period, Q8 */
+	period_q8 = (100000000000ULL << 8) / ((uint64_t)freq_chz * sample_ns);
+	if(period_q8 == 0)
+		return 0;
+	cycles = (uint32_t)(((uint64_t)max << 8) / period_q8);
+	if(cycles == 0)
+		return 0;
+	return (uint16_t)((cycles * period_q8 + 128U) >> 8);
+}
+
+/*
+ * Goertzel filter bank at the fundamental and its harmonics over num samples (num <= 1000)
+ * Each harmonic is one second-order filter tuned to the exact frequency, not to an FFT bin,
+ * so the cost is count * num iterations (about 25 cycles each, estimated from the instruction
+ * count, all 32-bit) whatever the resolution.
+ * The coefficient 2cos(w) in Q14 is the Q15 cosine, interpolated between table entries.
+ * Samples are centred and scaled to +-2048; while the record holds at least one period the
+ * filter state stays below 2048 * num^2 / 4pi < 2^28.
+ */
+void goertzel_harmonics(const uint16_t *buf, uint16_t num, uint8_t bits, uint32_t sample_ns,
+                        uint32_t freq_chz, uint8_t count, struct harm_result *res)
+{
+	uint64_t power[HARM_MAX];
+	uint64_t q = 0, qh = 0, top = 0, sum_h = 0, p1 = 0;
+	uint32_t sum = 0, turn = 0, frac = 0, thd = 0;
+	int32_t mean = 0, x = 0, coeff = 0, c0 = 0, s0 = 0, s1 = 0, s2 = 0;
+	int16_t lv = 0, lv1 = 0;
+	uint16_t i = 0, idx = 0;
+	uint8_t h = 0, shift = 0;
+
+	res->num = 0;
+	res->thd = 0;
+	if(count > HARM_MAX)
+		count = HARM_MAX;
+	if((num == 0) || (sample_ns == 0) || (freq_chz == 0))
+		return;
+
+	for(i = 0; i < num; i++)
+		sum += buf[i];
+	mean = (int32_t)(sum / num);
+
+	/* Fundamental frequency times sample interval, 1e11 per turn */
+	q = (uint64_t)freq_chz * sample_ns;
+	for(h = 0; h < count; h++)
+	{
+		qh = q * (h + 1U);
+		if(qh * 2U >= 100000000000ULL)
+			break;							/* At or above Nyquist */
+
+		/* Turns per sample in Q32: qh * 2^32 / 1e11 = qh * 2^21 / 5^11 */
+		turn = (uint32_t)((qh << 21) / 48828125ULL);
+		idx = (uint16_t)(turn >> 23);
+		frac = (turn >> 8) & 0x7FFFU;
+		c0 = fft_cos(idx);
+		coeff = c0 + (((fft_cos(idx + 1U) - c0) * (int32_t)frac) >> 15);
+
+		s1 = 0;
+		s2 = 0;
+		for(i = 0; i < num; i++)
+		{
+			x = (int32_t)buf[i] - mean;
+			x = (bits <= 12U) ? (x << (12U - bits)) : (x >> (bits - 12U));
+			/* Q14 product in two 32-bit halves, ARMv8-M Baseline has no SMULL: |coeff| <= 2^15 */
+			/* and |s1| < 2^28 keep both partial products under 2^29, the sum equals the floor */
+			s0 = x + coeff * (s1 >> 14) + ((coeff * (s1 & 0x3FFF)) >> 14) - s2;
+			s2 = s1;
+			s1 = s0;
+		}
+		power[h] = (uint64_t)((int64_t)s1 * s1 + (int64_t)s2 * s2 - (((int64_t)coeff * s1) >> 14) * s2);
+		if(power[h] > top)
+			top = power[h];
+	}
+	res->num = h;
+	if(h == 0)
+		return;
+
+	/* Common shift so every power fits the 32-bit level function */
+	while((top >> shift) > 0xFFFFFFFFULL)
+		shift++;
+
+	/* Full scale +-2048 gives |X| = 1024 * num */
+	for(h = 0; h < res->num; h++)
+	{
+		lv = (int16_t)(fft_level((uint32_t)(power[h] >> shift)) + (shift * 3010U + 50U) / 100U);
+		if(h == 0)
+		{
+			lv1 = lv;
+			res->level[0] = lv - (int16_t)(2U * fft_level(1024UL * num));
+		}
+		else
+		{
+			res->level[h] = lv - lv1;
+			sum_h += power[h] >> shift;
+		}
+	}
+
+	p1 = power[0] >> shift;
+	if(p1 != 0)
+	{
+		thd = goertzel_isqrt((sum_h * 100000000ULL) / p1);
+		res->thd = (thd > 0xFFFFU) ? 0xFFFFU : (uint16_t)thd;
+	}
+}
@@ -0,0 +1,35 @@
+#ifndef __MID_FFT_H
+#define __MID_FFT_H
+
+#include "main.h"
+
+#define FFT_N          512					/* Real input samples per transform */
+#define FFT_BINS       (FFT_N / 2)			/* Output bins, DC up to one below Nyquist */
+
+#define FFT_WIN_RECT   0x00					/* No window, best resolution for bin-centred tones */
+#define FFT_WIN_HANN   0x01					/* Hann window, low leakage */
+#define FFT_WIN_MAX    0x02
+
+#define FFT_LEVEL_FS   783					/* Level of a full-scale sine without window, 0.1dB */
+#define FFT_HANN_GAIN  60					/* Hann coherent gain loss, 0.1dB */
+
+#define HARM_MAX       8					/* Fundamental and harmonics analysed, H1..H8 */
+
+/*
+ * Harmonic analysis of one record
+ */
+struct harm_result
+{
+	uint8_t num;							/* Harmonics below Nyquist that were analysed, 0 = no result */
+	int16_t level[HARM_MAX];				/* [0] fundamental in 0.1dBFS, [n] harmonic n+1 in 0.1dBc */
+	uint16_t thd;							/* Total harmonic distortion of the analysed harmonics, 0.01% */
+};
+
+void fft_run(uint16_t *buf, uint8_t bits, uint8_t window);
+uint16_t fft_peak_bin(const uint16_t *level);
+uint32_t fft_peak_freq(const uint16_t *level, uint16_t bin, uint32_t sample_ns);
+uint16_t goertzel_record_len(uint32_t freq_chz, uint32_t sample_ns, uint16_t max);
+void goertzel_harmonics(const uint16_t *buf, uint16_t num, uint8_t bits, uint32_t sample_ns,
+                        uint32_t freq_chz, uint8_t count, struct harm_result *res);
+
+#endif
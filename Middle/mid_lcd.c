@@ -2,6 +2,37 @@
 #include "hw_lcdinit.h"
 #include "mid_font.h"
 
+static uint16_t tft_line[2][TFT_LINE_NUM];	/* DMA line buffers, one is sent while the other is filled */
+static uint8_t tft_line_sel = 0;			/* Buffer being filled */
+static uint16_t tft_line_cnt = 0;			/* Pixels in the buffer being filled */
+
+/*
+*   Function: Queue the pixels of the line buffer being filled and switch to the other one,
+*             a window must be open
+*   Parameters: None
+*   Return value: None
+*/
+static void TFT_LineFlush(void)
+{
+    if(tft_line_cnt == 0)
+        return;
+    TFT_Window_Burst(tft_line[tft_line_sel], tft_line_cnt);    // Waits for the other buffer to finish first
+    tft_line_sel ^= 1U;
+    tft_line_cnt = 0;
+}
+
+/*
+*   Function: Append one pixel to the line buffer, full buffers are queued
+*   Parameters: color--pixel color
+*   Return value: None
+*/
+static void TFT_LinePut(uint16_t color)
+{
+    tft_line[tft_line_sel][tft_line_cnt++] = color;
+    if(tft_line_cnt == TFT_LINE_NUM)
+        TFT_LineFlush();
+}
+
 /*
 *   Function: Fill the specified area with color
 *   Parameters: xsta,ysta---start coordinates
@@ -11,15 +42,69 @@
 */
 void TFT_Fill(uint16_t xsta,uint16_t ysta,uint16_t xend,uint16_t yend,uint16_t color)
 {
-    uint16_t i=0,j=0;
-    TFT_Address_Set(xsta,ysta,xend-1,yend-1);    // Set display range
-    for(i=ysta;i<yend;i++)
+    TFT_Window_Begin(xsta,ysta,xend-1,yend-1);    // Set display range
+    TFT_Window_Repeat(color,(uint32_t)(xend-xsta)*(yend-ysta));    // Large areas are queued and fill in the background
+    TFT_Window_End();
+}
+
+/*
+*   Function: Draw one column in a single address window, a span in the foreground and the
+*             rest of the window in the background
+*   Parameters: x-----------column
+*               ysta,yend---first and last row of the window
+*               top,bottom--first and last row of the span, may reach outside the window
+*               fc,bc-------span color, background color
+*   Return value: None
+*/
+void TFT_DrawSpan(uint16_t x,uint16_t ysta,uint16_t yend,uint16_t top,uint16_t bottom,uint16_t fc,uint16_t bc)
+{
+    uint16_t y=0;
+    TFT_Window_Begin(x,ysta,x,yend);    // One window for the whole column
+    if(yend-ysta+1<TFT_DMA_MIN)
     {
-        for(j=xsta;j<xend;j++)
+        for(y=ysta;y<=yend;y++)
         {
-            TFT_WR_DATA(color);
+            TFT_Window_Pixel(((y>=top)&&(y<=bottom))?fc:bc);
         }
     }
+    else
+    {
+        for(y=ysta;y<=yend;y++)
+        {
+            TFT_LinePut(((y>=top)&&(y<=bottom))?fc:bc);
+        }
+        TFT_LineFlush();    // Queued, the next column is computed while this one goes out
+    }
+    TFT_Window_End();
+}
+
+/*
+*   Function: Draw a run-length encoded image, pairs of run length and palette index
+*             Runs are decoded into the line buffers while the previous buffer goes out
+*   Parameters: x,y-----------top left corner
+*               width,height--image size
+*               rle-----------run length and palette index pairs
+*               size----------bytes of rle
+*               palette-------RGB565 colors
+*   Return value: None
+*/
+void TFT_DrawRLE(uint16_t x,uint16_t y,uint16_t width,uint16_t height,const uint8_t *rle,uint32_t size,const uint16_t *palette)
+{
+    uint32_t i=0;
+    uint8_t count=0;
+    uint16_t color=0;
+    TFT_Window_Begin(x,y,x+width-1,y+height-1);
+    for(i=0;i+1<size;i+=2)
+    {
+        count=rle[i];
+        color=palette[rle[i+1]];
+        while(count--)
+        {
+            TFT_LinePut(color);
+        }
+    }
+    TFT_LineFlush();
+    TFT_Window_End();
 }
 
 /*
@@ -30,8 +115,9 @@ void TFT_Fill(uint16_t xsta,uint16_t ysta,uint16_t xend,uint16_t yend,uint16_t c
 */
 void TFT_DrawPoint(uint16_t x,uint16_t y, uint16_t color)
 {
-    TFT_Address_Set(x,y,x,y);   // Set display range
-    TFT_WR_DATA(color);
+    TFT_Window_Begin(x,y,x,y);   // Set display range
+    TFT_Window_Pixel(color);
+    TFT_Window_End();
 }
 
 /*
@@ -46,6 +132,12 @@ void TFT_DrawLine(uint16_t x1,uint16_t y1,uint16_t x2,uint16_t y2,uint16_t color
 	uint16_t t=0;
 	int xerr=0,yerr=0,delta_x=0,delta_y=0,distance=0;
 	int incx=0,incy=0,uRow=0,uCol=0;
+	if((x1==x2)||(y1==y2))
+	{
+		// Horizontal and vertical lines are one window
+		TFT_Fill((x1<x2)?x1:x2,(y1<y2)?y1:y2,((x1<x2)?x2:x1)+1,((y1<y2)?y2:y1)+1,color);
+		return;
+	}
 	delta_x=x2-x1; // Calculate coordinate increments
 	delta_y=y2-y1;
 	uRow=x1;// Starting point of the line
@@ -112,27 +204,29 @@ void TFT_ShowChar(uint16_t x,uint16_t y,uint8_t num,uint16_t fc,uint16_t bc,uint
 	sizex=sizey/2;
 	TypefaceNum=(sizex/8+((sizex%8)?1:0))*sizey;
 	num=num-' ';     // Get offset value
-	TFT_Address_Set(x,y,x+sizex-1,y+sizey-1);  // Set cursor position
+	if((sizey!=16)&&(sizey!=24)){
+        return;
+    }
+	if(!mode){
+        TFT_Window_Begin(x,y,x+sizex-1,y+sizey-1);  // Set cursor position
+    }
 	for(i=0;i<TypefaceNum;i++)
 	{
 		if(sizey==16){
             temp=ascii_1608[num][i];		     // Call 16x8 font
 		}
-        else if(sizey==24){
+        else {
             temp=ascii_2412[num][i];		     // Call 12x24 font
-        }
-		else {
-            return;
         }
 		for(t=0;t<8;t++)
 		{
 			if(!mode)// Non-overlay mode
 			{
 				if(temp&(0x01<<t)){
-                    TFT_WR_DATA(fc);
+                    TFT_LinePut(fc);
                 }
 				else {
-                    TFT_WR_DATA(bc);
+                    TFT_LinePut(bc);
                 }
 				m++;
 				if(m%sizex==0)
@@ -156,6 +250,10 @@ void TFT_ShowChar(uint16_t x,uint16_t y,uint8_t num,uint16_t fc,uint16_t bc,uint
 			}
 		}
 	}
+	if(!mode){
+        TFT_LineFlush();
+        TFT_Window_End();
+    }
 }
 
 /*
@@ -178,6 +276,52 @@ void TFT_ShowString(uint16_t x,uint16_t y,const uint8_t *p,uint16_t fc,uint16_t
 	}
 }
 
+/*
+*   Function: Place a text field, nothing is known on screen until it is shown
+*             Called again after the area under it was cleared
+*   Parameters: field---text field
+*               x,y-----start coordinates
+*               sizey---font size
+*   Return value: None
+*/
+void TFT_FieldInit(struct tft_field *field,uint16_t x,uint16_t y,uint8_t sizey)
+{
+	field->x=x;
+	field->y=y;
+	field->sizey=sizey;
+	field->len=0;
+}
+
+/*
+*   Function: Show a string in a text field, only the character cells that differ from the
+*             retained text are drawn, an unchanged string sends nothing
+*             A shorter string leaves the cells after it as they are, like TFT_ShowString
+*   Parameters: field---text field
+*               str-----string, up to TFT_FIELD_LEN characters are shown
+*               fc,bc---font and background color, a change redraws every cell
+*   Return value: None
+*/
+void TFT_FieldShow(struct tft_field *field,const char *str,uint16_t fc,uint16_t bc)
+{
+	uint8_t i=0;
+
+	if((fc!=field->fc)||(bc!=field->bc))
+	{
+		field->fc=fc;
+		field->bc=bc;
+		field->len=0;
+	}
+	for(i=0;(i<TFT_FIELD_LEN)&&(str[i]!='\0');i++)
+	{
+		if((i<field->len)&&(field->text[i]==str[i]))
+			continue;
+		TFT_ShowChar(field->x+i*(field->sizey/2),field->y,str[i],fc,bc,field->sizey,0);
+		field->text[i]=str[i];
+	}
+	if(i>field->len)
+		field->len=i;
+}
+
 /******************************************************************************
       Function description: Display Chinese characters
       Input data: x,y display coordinates
@@ -231,7 +375,10 @@ void TFT_ShowChinese12x12(uint16_t x,uint16_t y,uint8_t *s,uint16_t fc,uint16_t
 	{
 		if((tfont12[k].Index[0]==*(s))&&(tfont12[k].Index[1]==*(s+1)))
 		{
-			TFT_Address_Set(x,y,x+sizey-1,y+sizey-1);
+			if(!mode)
+			{
+				TFT_Window_Begin(x,y,x+sizey-1,y+sizey-1);
+			}
 			for(i=0;i<TypefaceNum;i++)
 			{
 				for(j=0;j<8;j++)
@@ -240,11 +387,11 @@ void TFT_ShowChinese12x12(uint16_t x,uint16_t y,uint8_t *s,uint16_t fc,uint16_t
 					{
 						if(tfont12[k].Msk[i]&(0x01<<j))
 						{
-							TFT_WR_DATA(fc);
+							TFT_LinePut(fc);
 						}
 						else
 						{
-							TFT_WR_DATA(bc);
+							TFT_LinePut(bc);
 						}
 						m++;
 						if(m%sizey==0)
@@ -269,6 +416,11 @@ void TFT_ShowChinese12x12(uint16_t x,uint16_t y,uint8_t *s,uint16_t fc,uint16_t
 					}
 				}
 			}
+			if(!mode)
+			{
+				TFT_LineFlush();
+				TFT_Window_End();
+			}
 		}
 		continue;  // Exit after finding the corresponding font library to prevent repeated font retrieval
 	}
@@ -296,7 +448,10 @@ void TFT_ShowChinese16x16(uint16_t x,uint16_t y,uint8_t *s,uint16_t fc,uint16_t
 	{
 		if ((tfont16[k].Index[0]==*(s))&&(tfont16[k].Index[1]==*(s+1)))
 		{
-			TFT_Address_Set(x,y,x+sizey-1,y+sizey-1);
+			if(!mode)
+			{
+				TFT_Window_Begin(x,y,x+sizey-1,y+sizey-1);
+			}
 			for(i=0;i<TypefaceNum;i++)
 			{
 				for(j=0;j<8;j++)
@@ -304,10 +459,10 @@ void TFT_ShowChinese16x16(uint16_t x,uint16_t y,uint8_t *s,uint16_t fc,uint16_t
 					if(!mode)// Non-overlay mode
 					{
 						if(tfont16[k].Msk[i]&(0x01<<j)){
-							TFT_WR_DATA(fc);
+							TFT_LinePut(fc);
 						}
 						else {
-							TFT_WR_DATA(bc);
+							TFT_LinePut(bc);
 						}
 						m++;
 						if(m%sizey==0)
@@ -332,6 +487,11 @@ void TFT_ShowChinese16x16(uint16_t x,uint16_t y,uint8_t *s,uint16_t fc,uint16_t
 					}
 				}
 			}
+			if(!mode)
+			{
+				TFT_LineFlush();
+				TFT_Window_End();
+			}
 		}
 		continue;   // Exit after finding the corresponding font library to prevent repeated font retrieval
 	}
@@ -360,7 +520,10 @@ void TFT_ShowChinese24x24(uint16_t x,uint16_t y,uint8_t *s,uint16_t fc,uint16_t
 	{
 		if ((tfont24[k].Index[0]==*(s))&&(tfont24[k].Index[1]==*(s+1)))
 		{
-			TFT_Address_Set(x,y,x+sizey-1,y+sizey-1);
+			if(!mode)
+			{
+				TFT_Window_Begin(x,y,x+sizey-1,y+sizey-1);
+			}
 			for(i=0;i<TypefaceNum;i++)
 			{
 				for(j=0;j<8;j++)
@@ -368,10 +531,10 @@ void TFT_ShowChinese24x24(uint16_t x,uint16_t y,uint8_t *s,uint16_t fc,uint16_t
 					if(!mode)// Non-overlay mode
 					{
 						if(tfont24[k].Msk[i]&(0x01<<j)){
-                            TFT_WR_DATA(fc);
+                            TFT_LinePut(fc);
                         }
 						else{
-                            TFT_WR_DATA(bc);
+                            TFT_LinePut(bc);
                         }
 						m++;
 						if(m%sizey==0)
@@ -395,6 +558,11 @@ void TFT_ShowChinese24x24(uint16_t x,uint16_t y,uint8_t *s,uint16_t fc,uint16_t
 					}
 				}
 			}
+			if(!mode)
+			{
+				TFT_LineFlush();
+				TFT_Window_End();
+			}
 		}
 		continue;  // Exit after finding the corresponding font library to prevent repeated font retrieval
 	}
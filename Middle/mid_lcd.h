@@ -27,11 +27,32 @@
 #define LGRAYBLUE        0XA651 /* Light gray blue (middle layer color) */
 #define LBBLUE           0X2B12 /* Light brownish blue (selected item inverse color) */
 
+#define TFT_LINE_NUM     64		/* Pixels per DMA line buffer, two buffers are filled in turn */
+#define TFT_FIELD_LEN    20		/* Characters a text field retains, one screen width of 8-px cells */
+
+/*
+ * Retained text field, remembers what is on screen so only changed character cells are drawn
+ */
+struct tft_field
+{
+	uint16_t x;							/* Top left corner */
+	uint16_t y;
+	uint16_t fc;						/* Colors of the retained text */
+	uint16_t bc;
+	uint8_t sizey;						/* Font height */
+	uint8_t len;						/* Retained characters, 0 = nothing known on screen */
+	char text[TFT_FIELD_LEN];			/* Characters on screen */
+};
+
 void TFT_Fill(uint16_t xsta,uint16_t ysta,uint16_t xend,uint16_t yend,uint16_t color);
+void TFT_DrawSpan(uint16_t x,uint16_t ysta,uint16_t yend,uint16_t top,uint16_t bottom,uint16_t fc,uint16_t bc);
+void TFT_DrawRLE(uint16_t x,uint16_t y,uint16_t width,uint16_t height,const uint8_t *rle,uint32_t size,const uint16_t *palette);
 void TFT_DrawPoint(uint16_t x,uint16_t y, uint16_t color);
 void TFT_DrawLine(uint16_t x1,uint16_t y1,uint16_t x2,uint16_t y2,uint16_t color);
 void TFT_ShowChar(uint16_t x,uint16_t y,uint8_t num,uint16_t fc,uint16_t bc,uint8_t sizey,uint8_t mode);
 void TFT_ShowString(uint16_t x,uint16_t y,const uint8_t *p,uint16_t fc,uint16_t bc,uint8_t sizey,uint8_t mode);
+void TFT_FieldInit(struct tft_field *field,uint16_t x,uint16_t y,uint8_t sizey);
+void TFT_FieldShow(struct tft_field *field,const char *str,uint16_t fc,uint16_t bc);
 void TFT_ShowChinese(uint16_t x,uint16_t y,uint8_t *s,uint16_t fc,uint16_t bc,uint8_t sizey,uint8_t mode);
 void TFT_ShowChinese12x12(uint16_t x,uint16_t y,uint8_t *s,uint16_t fc,uint16_t bc,uint8_t sizey,uint8_t mode);
 void TFT_ShowChinese16x16(uint16_t x,uint16_t y,uint8_t *s,uint16_t fc,uint16_t bc,uint8_t sizey,uint8_t mode);
@@ -0,0 +1,315 @@
+#include "mid_measure.h"
+#include "string.h"
+
+static struct measure_result meas_res;		/* Results of the last record */
+static uint16_t meas_lo = 0;				/* Minimum of the previous record, sets the reference levels */
+static uint16_t meas_hi = 0;				/* Maximum of the previous record */
+
+/*
+ * Q8 sample position where the segment from sample i-1 (prev) to sample i (cur) passes level
+ */
+static uint32_t measure_cross_q8(uint16_t i, uint16_t prev, uint16_t cur, uint16_t level)
+{
+	uint32_t part = (prev < cur) ? (uint32_t)(level - prev) : (uint32_t)(prev - level);
+	uint32_t whole = (prev < cur) ? (uint32_t)(cur - prev) : (uint32_t)(prev - cur);
+
+	return ((uint32_t)(i - 1U) << 8) + (part << 8) / whole;
+}
+
+/*
+ * Integer square root, bit by bit
+ */
+static uint16_t measure_isqrt(uint32_t val)
+{
+	uint32_t res = 0, bit = 1UL << 30;
+
+	while(bit > val)
+		bit >>= 2;
+	while(bit != 0)
+	{
+		if(val >= res + bit)
+		{
+			val -= res + bit;
+			res = (res >> 1) + bit;
+		}
+		else
+		{
+			res >>= 1;
+		}
+		bit >>= 2;
+	}
+	return (uint16_t)res;
+}
+
+/*
+ * Q8 sample count to ns
+ */
+static uint32_t measure_q8_to_ns(uint32_t q8, uint32_t sample_ns)
+{
+	return (uint32_t)(((uint64_t)q8 * sample_ns) >> 8);
+}
+
+/*
+ * Running state of the record being measured
+ */
+struct measure_acc
+{
+	uint16_t num;						/* Samples fed so far */
+	uint16_t prev;						/* Previous sample (mid of the column in peak detect) */
+	uint16_t v_min, v_max;				/* Extremes so far */
+	uint16_t l10, l50, l90, hyst;		/* Reference levels from the previous record */
+	uint16_t rises, rise_edges, fall_edges;
+	uint16_t high_cnt, high_at_rise;
+	uint32_t sum;
+	uint64_t sum_sq;
+	uint32_t cand50, cand10, cand90;	/* Latest Q8 crossing candidates */
+	uint32_t first_rise, last_rise, rise_sum, fall_sum;
+	uint8_t edges, high, arm_rise, arm_fall;
+};
+
+static struct measure_acc meas_acc;
+
+/*
+ * Start a record: reference levels from the previous record, accumulators cleared
+ * The record is then fed with measure_sample() from the loop that converts it for display,
+ * so the samples are read once per frame, and closed with measure_end()
+ */
+void measure_begin(uint8_t bits)
+{
+	struct measure_acc *a = &meas_acc;
+	uint16_t span = 0;
+
+	memset(a, 0, sizeof(*a));
+	a->v_min = 0xFFFF;
+
+	/* Edge timing needs a swing of at least 1/64 full scale */
+	span = (meas_hi > meas_lo) ? (meas_hi - meas_lo) : 0;
+	a->edges = ((uint32_t)span >= ((1U << bits) >> 6));
+	a->l10 = meas_lo + span / 10U;
+	a->l50 = meas_lo + span / 2U;
+	a->l90 = meas_hi - span / 10U;
+	a->hyst = span / 16U;
+}
+
+/*
+ * Feed one sample, hi == lo except in peak detect, where the column spans lo..hi
+ * Edges are found at 10/50/90% of the previous record's min/max so the levels need no extra pass,
+ * a level change settles one frame later. Crossings are interpolated to 1/256 sample.
+ * Cycle budget, estimated from the instruction count and not measured on target (the Cortex-M23
+ * has no DWT cycle counter): about 80 cycles per sample including the call and the state kept in
+ * RAM, divides only run at detected edges, 155 samples ~12k cycles (~170us at 72MHz)
+ */
+void measure_sample(uint16_t hi, uint16_t lo)
+{
+	struct measure_acc *a = &meas_acc;
+	uint16_t i = a->num++;
+	uint16_t val = (uint16_t)(((uint32_t)hi + lo) >> 1);
+
+	if(lo < a->v_min)
+		a->v_min = lo;
+	if(hi > a->v_max)
+		a->v_max = hi;
+	a->sum += val;
+	a->sum_sq += (uint32_t)val * val;
+
+	if(i == 0)
+	{
+		a->high = (val > a->l50);
+	}
+	else if(a->edges)
+	{
+		/* Latest crossing candidates, used when the hysteresis band confirms the edge */
+		if((a->prev <= a->l50) && (val > a->l50))
+			a->cand50 = measure_cross_q8(i, a->prev, val, a->l50);
+		if((a->prev <= a->l10) && (val > a->l10))
+			a->cand10 = measure_cross_q8(i, a->prev, val, a->l10);
+		if((a->prev >= a->l90) && (val < a->l90))
+			a->cand90 = measure_cross_q8(i, a->prev, val, a->l90);
+
+		if(a->high)
+			a->high_cnt++;
+		if(!a->high && (val > a->l50 + a->hyst))
+		{
+			a->high = 1;
+			if(a->rises == 0)
+			{
+				a->first_rise = a->cand50;
+				a->high_cnt = 0;
+			}
+			else
+			{
+				a->last_rise = a->cand50;
+				a->high_at_rise = a->high_cnt;
+			}
+			a->rises++;
+		}
+		else if(a->high && (val + a->hyst < a->l50))
+		{
+			a->high = 0;
+		}
+
+		/* Rise: below 10% since the last measured rise, then through 90% */
+		if(val < a->l10)
+		{
+			a->arm_rise = 1;
+		}
+		else if(a->arm_rise && (a->prev <= a->l90) && (val > a->l90))
+		{
+			a->rise_sum += measure_cross_q8(i, a->prev, val, a->l90) - a->cand10;
+			a->rise_edges++;
+			a->arm_rise = 0;
+		}
+
+		/* Fall: above 90% since the last measured fall, then through 10% */
+		if(val > a->l90)
+		{
+			a->arm_fall = 1;
+		}
+		else if(a->arm_fall && (a->prev >= a->l10) && (val < a->l10))
+		{
+			a->fall_sum += measure_cross_q8(i, a->prev, val, a->l10) - a->cand90;
+			a->fall_edges++;
+			a->arm_fall = 0;
+		}
+	}
+	a->prev = val;
+}
+
+/*
+ * Close the record and publish the results, a record that is dropped half way is simply
+ * not closed and the previous results stay
+ */
+void measure_end(uint32_t sample_ns)
+{
+	const struct measure_acc *a = &meas_acc;
+
+	if(a->num == 0)
+		return;
+
+	meas_res.min = a->v_min;
+	meas_res.max = a->v_max;
+	meas_res.mean = (uint16_t)(a->sum / a->num);
+	meas_res.rms = measure_isqrt((uint32_t)(a->sum_sq / a->num));
+
+	meas_res.period_ns = 0;
+	meas_res.duty = 0;
+	if((a->rises >= 2) && (a->last_rise > a->first_rise))
+	{
+		meas_res.period_ns = measure_q8_to_ns((a->last_rise - a->first_rise) / (a->rises - 1U), sample_ns);
+		meas_res.duty = (uint16_t)(((uint32_t)a->high_at_rise * 256000UL) / (a->last_rise - a->first_rise));
+	}
+	meas_res.rise_ns = (a->rise_edges > 0) ? measure_q8_to_ns(a->rise_sum / a->rise_edges, sample_ns) : 0U;
+	meas_res.fall_ns = (a->fall_edges > 0) ? measure_q8_to_ns(a->fall_sum / a->fall_edges, sample_ns) : 0U;
+
+	/* Reference levels for the next record */
+	meas_lo = a->v_min;
+	meas_hi = a->v_max;
+}
+
+/*
+ * Get the results of the last record
+ */
+const struct measure_result *get_measure_result(void)
+{
+	return &meas_res;
+}
+
+/*
+ * One pass over a pre-capture: amplitude histogram of MEAS_HIST_BINS bins from base, 1 << shift
+ * counts wide, and the rising crossings of every bin boundary. Boundary k arms when the signal
+ * is in bin k-2 or lower and fires when it reaches bin k, so one bin of hysteresis. The armed
+ * boundaries are a bit mask, the per-boundary loop only runs on samples that fire an edge
+ */
+static void measure_survey_pass(const uint16_t *buf, uint16_t num, uint16_t base, uint8_t shift,
+                                uint32_t sample_ns, struct measure_survey *res)
+{
+	uint16_t count[MEAS_HIST_BINS] = {0};
+	uint32_t sum[MEAS_HIST_BINS] = {0};
+	uint16_t cross[MEAS_HIST_BINS] = {0};
+	uint16_t first[MEAS_HIST_BINS] = {0};
+	uint16_t last[MEAS_HIST_BINS] = {0};
+	uint32_t armed = 0, fired = 0;
+	uint16_t i = 0, acc = 0, skip = num / 64U;
+	uint8_t b = 0, k = 0, lo = 0, hi = 0;
+
+	for(i = 0; i < num; i++)
+	{
+		b = (buf[i] > base) ? (uint8_t)(((uint32_t)buf[i] - base) >> shift) : 0U;
+		if(b >= MEAS_HIST_BINS)
+			b = MEAS_HIST_BINS - 1U;
+		count[b]++;
+		sum[b] += buf[i];
+
+		fired = armed & ((2UL << b) - 1U);
+		armed = (armed & ~fired) | ~((4UL << b) - 1U);
+		for(k = 0; fired != 0; k++, fired >>= 1)
+		{
+			if(fired & 1U)
+			{
+				if(cross[k] == 0)
+					first[k] = i;
+				last[k] = i;
+				cross[k]++;
+			}
+		}
+	}
+
+	/* The outermost 1/64 of the samples are spikes, they do not set the levels */
+	for(lo = 0, acc = 0; lo < MEAS_HIST_BINS - 1U; lo++)
+	{
+		acc += count[lo];
+		if(acc > skip)
+			break;
+	}
+	for(hi = MEAS_HIST_BINS - 1U, acc = 0; hi > lo; hi--)
+	{
+		acc += count[hi];
+		if(acc > skip)
+			break;
+	}
+	res->low = (uint16_t)(sum[lo] / count[lo]);
+	res->high = (count[hi] != 0) ? (uint16_t)(sum[hi] / count[hi]) : res->low;
+
+	/* Edges at the boundary nearest the mid level, it needs a bin below it to arm */
+	res->rises = 0;
+	res->period_ns = 0;
+	k = (uint8_t)(((((uint32_t)res->low + res->high) / 2U - base) + (1UL << shift) / 2U) >> shift);
+	if((k >= lo + 2U) && (k <= hi))
+	{
+		res->rises = cross[k];
+		if(cross[k] >= 2)
+			res->period_ns = (uint32_t)(((uint64_t)(last[k] - first[k]) * sample_ns) / (cross[k] - 1U));
+	}
+}
+
+/*
+ * Autoset survey: levels and edge rate of a pre-capture of num samples
+ * The first pass spans full scale, a swing under 1/4 of it gets a second pass with the bins
+ * spread over the populated range so small signals still resolve their edges.
+ * Swings under 1/64 full scale report no edges
+ */
+void measure_survey(const uint16_t *buf, uint16_t num, uint32_t sample_ns, uint8_t bits, struct measure_survey *res)
+{
+	uint8_t shift = bits - 5U;
+	uint16_t base = 0, span = 0;
+
+	if(num == 0)
+		return;
+
+	measure_survey_pass(buf, num, 0, shift, sample_ns, res);
+	span = res->high - res->low;
+	if(span < ((1UL << bits) >> 6))
+	{
+		res->rises = 0;
+		res->period_ns = 0;
+		return;
+	}
+	if(span >= ((1UL << bits) >> 2))
+		return;
+
+	/* Zoom: one bin of margin on each side of the levels */
+	while((shift > 0) && ((((uint32_t)span + (1UL << shift)) >> (shift - 1U)) < MEAS_HIST_BINS))
+		shift--;
+	base = (res->low > (1U << shift)) ? (res->low - (1U << shift)) : 0U;
+	measure_survey_pass(buf, num, base, shift, sample_ns, res);
+}
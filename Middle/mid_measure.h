@@ -0,0 +1,49 @@
+#ifndef __MID_MEASURE_H
+#define __MID_MEASURE_H
+
+#include "main.h"
+
+#define MEAS_VPP     0x00				/* Peak to peak */
+#define MEAS_MEAN    0x01				/* Average */
+#define MEAS_RMS     0x02				/* RMS including DC */
+#define MEAS_PERIOD  0x03				/* Period of the waveform in the record */
+#define MEAS_DUTY    0x04				/* Positive duty cycle */
+#define MEAS_RISE    0x05				/* 10% - 90% rise time */
+#define MEAS_FALL    0x06				/* 90% - 10% fall time */
+#define MEAS_MAX     0x07
+
+#define MEAS_HIST_BINS 32				/* Amplitude histogram bins of the autoset survey */
+
+/*
+ * Measurement results of one record, levels in ADC counts, times in ns, 0 = not measurable
+ */
+struct measure_result
+{
+	uint16_t min;						/* Lowest sample */
+	uint16_t max;						/* Highest sample */
+	uint16_t mean;						/* Average */
+	uint16_t rms;						/* Root mean square */
+	uint32_t period_ns;					/* Mean distance of the rising mid-level crossings */
+	uint16_t duty;						/* High time over whole periods, 0.1% */
+	uint32_t rise_ns;					/* Mean 10% - 90% rise time */
+	uint32_t fall_ns;					/* Mean 90% - 10% fall time */
+};
+
+/*
+ * Autoset survey of a pre-capture, levels in sample counts
+ */
+struct measure_survey
+{
+	uint16_t low;						/* Low level, mean of the lowest populated bin */
+	uint16_t high;						/* High level, mean of the highest populated bin */
+	uint16_t rises;						/* Rising crossings of the mid level, 0 = flat or too small */
+	uint32_t period_ns;					/* Mean distance of the rising crossings, 0 = fewer than two */
+};
+
+void measure_begin(uint8_t bits);
+void measure_sample(uint16_t hi, uint16_t lo);
+void measure_end(uint32_t sample_ns);
+const struct measure_result *get_measure_result(void);
+void measure_survey(const uint16_t *buf, uint16_t num, uint32_t sample_ns, uint8_t bits, struct measure_survey *res);
+
+#endif
@@ -1,10 +1,13 @@
 #include "mid_timer.h"
+#include "hw_tim.h"
 
 static __IO uint16_t key_timer_value;			//ʱ
 static __IO uint16_t tft_timer_value;			//Ļʱ
 static uint8_t key_timer_bit = RUN_MS_TIMER;		//msʱ־λ
 static uint8_t tft_timer_bit = RUN_MS_TIMER;		//msʱ־λ
 
+static void freq_ms_tick(void);
+
 /*
  * ݣʱжϻص
  * TIM_HandleTypeDef *htim -- ʱ
@@ -13,6 +16,8 @@ static uint8_t tft_timer_bit = RUN_MS_TIMER;		//ms
  
 void TIMER15_IRQHandler(void)
 {
+	freq_ms_tick();			//ȶȡֵբŶС
+
 	if(key_timer_bit == RUN_MS_TIMER)
 	{
 		key_timer_value++;
@@ -91,47 +96,219 @@ void set_tft_bit_value(uint8_t value)
 	tft_timer_bit = value;
 }
 
-static __IO uint16_t ccnumber = 0;						//
-static __IO uint32_t freq = 0;							//Ƶֵ
-static __IO uint16_t readvalue1 = 0, readvalue2 = 0;	//βֵ
-static __IO uint32_t count = 0;							//ڼʱ
+static __IO uint32_t freq = 0;							//Ƶֵ0.01Hz0 = ź
+static __IO uint16_t freq_duty = 0;						//ռձȣ0.1%0 = ޷
+static __IO uint32_t freq_width = 0;					//ߵƽȣ72MHzֵ
+static __IO uint8_t freq_mode = FREQ_MODE_GATE;			//Ƶʽ
+static uint8_t freq_range = 0;							//PWMԤƵλ
+static uint16_t freq_gate_last = 0;						//һıؼֵ
+static uint16_t freq_gate_ms = 0;						//բѼʱ
+static uint32_t freq_gate_sum = 0;						//բڱ֮
+static uint32_t freq_gate_high = 0;						//բڸߵƽ֮
+static uint16_t freq_gate_num = 0;						//բPWM
+static uint8_t freq_gate_skip = 0;						//лĵһPWM
+
+/* PWMԤƵ72MHz1MHz50kHz16λڷֱ𸲸1.1kHz15Hz0.76Hz */
+static const uint16_t freq_psc_tab[FREQ_RANGE_NUM] = {0, 71, 1439};
+
+/* ڴƵʻһ0բż */
+static const uint32_t freq_up_tab[FREQ_RANGE_NUM] = {FREQ_GATE_UP_HZ, FREQ_PWM_UP_HZ, FREQ_LOW_UP_HZ};
 
 /*
- * ݣʱͨص
- * TIM_HandleTypeDef *htim -- ʱ
+ * ݣлբżʽ
+ * 
  * ֵ
+ * ˵PA6ֱΪʱ2ļʱӣʱ2ٲжϣ
+ *       բ1msʱ15ÿһμֵ16λ1msڲƻء
  */
-void TIMER2_IRQHandler(void)
+static void freq_gate_start(void)
 {
-	if(SET == timer_interrupt_flag_get(TIMER2, TIMER_INT_FLAG_CH0))
-  {
-		if(0 == ccnumber){
-			readvalue1 = timer_channel_capture_value_register_read(TIMER2, TIMER_CH_0);
-			ccnumber = 1;
-		}
-		else if(1 == ccnumber)
+	freq_mode = FREQ_MODE_GATE;
+	freq_duty = 0;
+	freq_width = 0;
+	freq_gate_ms = 0;
+	freq_gate_sum = 0;
+	mx_tim2_mode_config(TIM2_MODE_COUNT, 0);
+	freq_gate_last = (uint16_t)timer_counter_read(TIMER2);
+}
+
+/*
+ * ݣлPWM뷽ʽ
+ * uint8_t range -- ԤƵλ0 = 72MHz
+ * ֵ
+ * ˵ظλͨ0ڣͨ1ߵƽȣ
+ *       ʱ2жϣ1msʱ15ȡĴƽ
+ *       ƵʱӴԤƵʹڱ16λڣ浹չ
+ *       չҪÿغÿжϣԤƵλֻ1msѯ־
+ *       һ(50kHz)ķֱΪ20us1HzʱΪ0.002%
+ */
+static void freq_pwm_start(uint8_t range)
+{
+	freq_mode = FREQ_MODE_PWM;
+	freq_range = range;
+	freq_gate_ms = 0;
+	freq_gate_sum = 0;
+	freq_gate_high = 0;
+	freq_gate_num = 0;
+	freq_gate_skip = 1;
+	mx_tim2_mode_config(TIM2_MODE_PWM, freq_psc_tab[range]);
+}
+
+/*
+ * ݣբżÿ1msһ
+ * 
+ * ֵ
+ */
+static void freq_gate_tick(void)
+{
+	uint16_t now = 0;
+	uint32_t hz = 0;
+
+	now = (uint16_t)timer_counter_read(TIMER2);
+	freq_gate_sum += (uint16_t)(now - freq_gate_last);
+	freq_gate_last = now;
+	if(++freq_gate_ms < FREQ_GATE_MS)
+		return;
+
+	hz = freq_gate_sum * (1000U / FREQ_GATE_MS);
+	freq_gate_ms = 0;
+	freq_gate_sum = 0;
+
+	/* ƵʽͺPWM룬ֱʸߣբֱֻ10Hzлʱϴζ
+	   PWMźʱբŷʽ */
+	if((hz != 0) && (hz < FREQ_PWM_UP_HZ))
+	{
+		freq_pwm_start(1);
+		return;
+	}
+	if((hz != 0) && (hz < FREQ_GATE_DOWN_HZ))
+	{
+		freq_pwm_start(0);
+		return;
+	}
+	freq = hz * 100U;
+}
+
+/*
+ * ݣPWMÿ1msһ
+ * 
+ * ֵ
+ */
+static void freq_pwm_tick(void)
+{
+	uint16_t period = 0, high = 0;
+	uint32_t psc = freq_psc_tab[freq_range] + 1U;
+	uint64_t ticks = 0;
+
+	/* ˵ڳ16λϴζѲٻһ
+	   һźʧһغ1.31sźţ
+	   72MHzʼԼ1.38sصբŷʽ */
+	if(SET == timer_flag_get(TIMER2, TIMER_FLAG_UP))
+	{
+		freq = 0;
+		freq_duty = 0;
+		freq_width = 0;
+		if(freq_range < FREQ_RANGE_NUM - 1U)
+			freq_pwm_start(freq_range + 1U);
+		else
+			freq_gate_start();
+		return;
+	}
+
+	/* ͨ0־ʾ1msµڣֵͬʱ־ */
+	if(SET == timer_flag_get(TIMER2, TIMER_FLAG_CH0))
+	{
+		period = timer_channel_capture_value_register_read(TIMER2, TIMER_CH_0);
+		high = timer_channel_capture_value_register_read(TIMER2, TIMER_CH_1);
+		timer_flag_clear(TIMER2, TIMER_FLAG_CH0 | TIMER_FLAG_CH1);
+		if(freq_gate_skip)
+			freq_gate_skip = 0;
+		else if((period != 0) && (high < period))
 		{
-			readvalue2 = timer_channel_capture_value_register_read(TIMER2, TIMER_CH_0);
-			if(readvalue2 > readvalue1){
-				count = (readvalue2 - readvalue1); 
-			}else{
-				count = ((0xFFFFU - readvalue1) + readvalue2); 
-			}
-			freq = 1000000U / count;			
-			readvalue1 = 0;readvalue2 = 0;
-			ccnumber = 0;
-			count=0;
+			freq_gate_sum += period;
+			freq_gate_high += high;
+			freq_gate_num++;
 		}
-		timer_interrupt_flag_clear(TIMER2, TIMER_INT_FLAG_CH0);
+	}
+
+	if(freq_gate_ms < FREQ_GATE_MS)
+		freq_gate_ms++;
+
+	/* բʱ䵽жۼƵբʱʱNƵʱ仯
+	   1kHzÿ1msȡһڣNԼΪ100100HzβӣNΪڵ
+	   ڳբʱʱÿڳһνһբ */
+	ticks = (uint64_t)freq_gate_sum * psc;
+	if((freq_gate_num == 0) || ((freq_gate_ms < FREQ_GATE_MS) && (ticks < FREQ_GATE_TICKS)))
+		return;
+
+	freq = (uint32_t)(((uint64_t)freq_gate_num * FREQ_CLK_HZ * 100U + ticks / 2U) / ticks);
+	freq_duty = (uint16_t)(((uint64_t)freq_gate_high * 1000U) / freq_gate_sum);
+	freq_width = freq_gate_high / freq_gate_num * psc;
+	freq_gate_ms = 0;
+	freq_gate_sum = 0;
+	freq_gate_high = 0;
+	freq_gate_num = 0;
+
+	if(freq / 100U > freq_up_tab[freq_range])
+	{
+		if(freq_range == 0)
+			freq_gate_start();
+		else
+			freq_pwm_start(freq_range - 1U);
 	}
 }
 
+/*
+ * ݣբżʱ1msже
+ * 
+ * ֵ
+ */
+static void freq_ms_tick(void)
+{
+	if(freq_mode == FREQ_MODE_GATE)
+		freq_gate_tick();
+	else
+		freq_pwm_tick();
+}
+
 /*
  * ݣõƵֵ
  * 
- * ֵuint32_t -- Ƶֵ
+ * ֵuint32_t -- ƵֵHz0 = ź
  */
 uint32_t get_freq_value(void)
+{
+	return (freq + 50U) / 100U;
+}
+
+/*
+ * ݣõƵֵ
+ * 
+ * ֵuint32_t -- Ƶֵ0.01Hz0 = ź
+ */
+uint32_t get_freq_centi_value(void)
 {
 	return freq;
 }
+
+/*
+ * ݣõռձ
+ * 
+ * ֵuint16_t -- ߵƽռձȣ0.1%0 = բżʽ޷
+ */
+uint16_t get_freq_duty_value(void)
+{
+	return freq_duty;
+}
+
+/*
+ * ݣõ
+ * 
+ * ֵuint32_t -- ߵƽȣns0 = ޷
+ */
+uint32_t get_freq_width_value(void)
+{
+	uint32_t ticks = freq_width;
+
+	return (ticks / FREQ_CLK_MHZ) * 1000U + ((ticks % FREQ_CLK_MHZ) * 1000U) / FREQ_CLK_MHZ;
+}
@@ -6,6 +6,19 @@
 #define PAUSE_MS_TIMER 0x01
 #define RUN_MS_TIMER   0x02
 
+#define FREQ_CLK_HZ       72000000UL					//ʱ2ԤƵǰļƵ
+#define FREQ_CLK_MHZ      (FREQ_CLK_HZ / 1000000UL)
+#define FREQ_GATE_MS      100U							//բʱ 100ms
+#define FREQ_GATE_TICKS   (FREQ_CLK_HZ / 1000U * FREQ_GATE_MS)	//բʱۺ72MHzֵ
+#define FREQ_RANGE_NUM    3U							//PWMԤƵλ
+#define FREQ_LOW_UP_HZ    20UL							//ڴƵPWM50kHz1MHz
+#define FREQ_PWM_UP_HZ    1200UL						//ڴƵPWM72MHz16λ
+#define FREQ_GATE_UP_HZ   100000UL						//ڴƵʸբż
+#define FREQ_GATE_DOWN_HZ 50000UL						//բżڴƵʸĻPWM
+
+#define FREQ_MODE_GATE    0x01							//բżΪʱ
+#define FREQ_MODE_PWM     0x02							//PWM룺ظλͨ0/1ںƵлԤƵ
+
 uint16_t get_key_timer_value(void);
 void set_key_timer_value(uint16_t value);
 void set_key_bit_value(uint8_t value);
@@ -15,5 +28,8 @@ void set_tft_timer_value(uint16_t value);
 void set_tft_bit_value(uint8_t value);
 
 uint32_t get_freq_value(void);
+uint32_t get_freq_centi_value(void);
+uint16_t get_freq_duty_value(void);
+uint32_t get_freq_width_value(void);
 
 #endif
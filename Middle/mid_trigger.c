@@ -0,0 +1,151 @@
+#include "mid_trigger.h"
+
+/*
+ * Transition entry: next state in the low bits, actions above
+ */
+#define TRIG_ST_LOW      0x00				/* Below the low threshold */
+#define TRIG_ST_HIGH     0x01				/* Above the high threshold, or inside a runt candidate */
+#define TRIG_ST_WAIT     0x02				/* Not known yet after arming */
+#define TRIG_ST_TALL     0x03				/* Runt: the pulse reached the top, not a runt */
+#define TRIG_ST_MASK     0x03
+#define TRIG_ACT_FIRE    0x04				/* Trigger at this sample */
+#define TRIG_ACT_MARK    0x08				/* Pulse starts at this sample */
+#define TRIG_ACT_WIDTH   0x10				/* Pulse ends, fire if the width matches */
+#define TRIG_ACT_MASK    0x1C
+
+#define L                TRIG_ST_LOW
+#define H                TRIG_ST_HIGH
+#define W                TRIG_ST_WAIT
+#define T                TRIG_ST_TALL
+#define F                TRIG_ACT_FIRE
+#define M                TRIG_ACT_MARK
+#define C                TRIG_ACT_WIDTH
+
+/*
+ * Transition table [mode][state][zone]
+ * Zone of a sample: 0 at or below the low threshold, 1 inside the hysteresis band,
+ * 2 at or above the high threshold, 3 at or above the top (runt only, otherwise unreachable)
+ */
+static const uint8_t trig_tab[TRIG_MODE_MAX][4][4] =
+{
+	/* Rising */
+	{{L, L, H|F, H|F}, {L, H, H, H}, {L, W, H, H}, {L, T, T, T}},
+	/* Falling */
+	{{L, L, H, H}, {L|F, H, H, H}, {L, W, H, H}, {L, T, T, T}},
+	/* Either edge */
+	{{L, L, H|F, H|F}, {L|F, H, H, H}, {L, W, H, H}, {L, T, T, T}},
+	/* Pulse wider than the width, a pulse already high when armed has no start and is skipped */
+	{{L, L, H|M, H|M}, {L|C, H, H, H}, {L, W, T, T}, {L, T, T, T}},
+	/* Pulse narrower than the width */
+	{{L, L, H|M, H|M}, {L|C, H, H, H}, {L, W, T, T}, {L, T, T, T}},
+	/* Runt: inside the pulse until it either falls back (runt) or reaches the top */
+	{{L, L, H, T}, {L|F, H, H, T}, {L, T, T, T}, {L, T, T, T}},
+};
+
+#undef L
+#undef H
+#undef W
+#undef T
+#undef F
+#undef M
+#undef C
+
+static const uint8_t *trig_row = trig_tab[0][TRIG_ST_WAIT];	/* Transitions of the current state */
+static uint8_t trig_mode = TRIG_MODE_RISE;		/* Mode being searched */
+static uint8_t trig_state = TRIG_ST_WAIT;		/* State carried between blocks */
+static uint16_t trig_lo = 0;					/* Low threshold, sample units */
+static uint16_t trig_hi = 0;					/* High threshold (the level), sample units */
+static uint16_t trig_top = 0xFFFF;				/* Runt top, sample units */
+static uint16_t trig_width = 0;					/* Pulse width limit in samples */
+static uint32_t trig_count = 0;					/* Samples searched since arming */
+static uint32_t trig_mark = 0;					/* Sample count at the start of the pulse */
+
+/*
+ * Start a new search, levels in the units of the samples that will be searched
+ * The signal has to pass the hysteresis band below level before the first edge counts, so
+ * noise on the level does not fire. Falling and either edge use the same band, a falling
+ * edge fires at level - hyst. top only applies to runt, width only to the pulse modes.
+ */
+void trigger_arm(uint8_t mode, uint16_t level, uint16_t hyst, uint16_t top, uint16_t width)
+{
+	if(mode >= TRIG_MODE_MAX)
+		mode = TRIG_MODE_RISE;
+	trig_mode = mode;
+	trig_hi = level;
+	trig_lo = (level > hyst) ? (level - hyst) : 0;
+	trig_top = (mode == TRIG_MODE_RUNT) ? top : 0xFFFFU;
+	trig_width = width;
+	trig_state = (mode == TRIG_MODE_RUNT) ? TRIG_ST_TALL : TRIG_ST_WAIT;
+	trig_row = trig_tab[mode][trig_state];
+	trig_count = 0;
+	trig_mark = 0;
+}
+
+/*
+ * Actions of one transition, rare next to the plain state changes
+ */
+static uint8_t trigger_act(uint8_t e, uint16_t i)
+{
+	uint32_t width = 0;
+
+	if(e & TRIG_ACT_MARK)
+	{
+		trig_mark = trig_count + i;
+		return 0;
+	}
+	if(e & TRIG_ACT_WIDTH)
+	{
+		width = trig_count + i - trig_mark;
+		return (trig_mode == TRIG_MODE_PW_GT) ? (width > trig_width) : (width < trig_width);
+	}
+	return 1;
+}
+
+/*
+ * Walk a block once, the state carries over to the next block
+ * The ring holds 16-bit samples, or one byte per sample in packed 8-bit mode; both widths
+ * go through this one loop so every mode change lands in a single place
+ * Per sample: one fetch of the ring width, zone from three compares, one table load,
+ * one test for an action
+ * Return: index of the trigger sample in the block, TRIG_NONE if there is none
+ */
+static uint16_t trigger_walk(const void *buf, uint8_t packed, uint16_t num)
+{
+	const uint8_t (*tab)[4] = trig_tab[trig_mode];
+	const uint8_t *row = trig_row;
+	uint16_t lo = trig_lo, hi = trig_hi, top = trig_top;
+	uint16_t i = 0, v = 0;
+	uint8_t e = 0;
+
+	for(i = 0; i < num; i++)
+	{
+		v = packed ? ((const uint8_t *)buf)[i] : ((const uint16_t *)buf)[i];
+		e = row[(v > lo) + (v >= hi) + (v >= top)];
+		row = tab[e & TRIG_ST_MASK];
+		if((e & TRIG_ACT_MASK) && trigger_act(e, i))
+		{
+			trig_row = row;
+			trig_count += i + 1U;
+			return i;
+		}
+	}
+	trig_row = row;
+	trig_count += num;
+	return TRIG_NONE;
+}
+
+/*
+ * Search a block of 16-bit samples
+ */
+uint16_t trigger_search(const uint16_t *buf, uint16_t num)
+{
+	return trigger_walk(buf, 0, num);
+}
+
+/*
+ * Search a block of packed 8-bit samples
+ */
+uint16_t trigger_search8(const uint8_t *buf, uint16_t num)
+{
+	return trigger_walk(buf, 1, num);
+}
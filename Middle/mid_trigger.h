@@ -0,0 +1,20 @@
+#ifndef __MID_TRIGGER_H
+#define __MID_TRIGGER_H
+
+#include "main.h"
+
+#define TRIG_MODE_RISE   0x00				/* Rising edge through the level */
+#define TRIG_MODE_FALL   0x01				/* Falling edge through the level */
+#define TRIG_MODE_EDGE   0x02				/* Either edge */
+#define TRIG_MODE_PW_GT  0x03				/* Positive pulse wider than the width, fires at its end */
+#define TRIG_MODE_PW_LT  0x04				/* Positive pulse narrower than the width, fires at its end */
+#define TRIG_MODE_RUNT   0x05				/* Pulse through the level that falls back without reaching the top */
+#define TRIG_MODE_MAX    0x06
+
+#define TRIG_NONE        0xFFFF				/* trigger_search(): no trigger in the block */
+
+void trigger_arm(uint8_t mode, uint16_t level, uint16_t hyst, uint16_t top, uint16_t width);
+uint16_t trigger_search(const uint16_t *buf, uint16_t num);
+uint16_t trigger_search8(const uint8_t *buf, uint16_t num);
+
+#endif
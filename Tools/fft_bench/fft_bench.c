@@ -0,0 +1,90 @@
+/*
+ * Host benchmark of Middle/mid_fft.c
+ * Runs fft_run on a 12-bit test tone for each window and reports the time per transform,
+ * plus TSC cycles on x86 hosts. The peak bin is printed as a check that the build is sane.
+ * Host figures track relative changes to the transform, they are not Cortex-M23 cycles.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "mid_fft.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_TSC 1
+#endif
+
+#define BENCH_RUNS   20000					/* Transforms per window */
+#define BENCH_BITS   12						/* Sample width */
+#define BENCH_BIN    37						/* Test tone, bin-centred for the RECT window */
+
+static uint16_t tone[FFT_N];				/* Test record, copied before every transform */
+static uint16_t work[FFT_N];				/* fft_run works in place */
+
+static double bench_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void bench_window(uint8_t window, const char *name)
+{
+	double t0 = 0, t_run = 0, t_copy = 0;
+	unsigned long long c0 = 0, c_run = 0, c_copy = 0;
+	uint32_t i = 0;
+	uint16_t bin = 0;
+
+	/* Copy cost alone, subtracted from the timed loop */
+	t0 = bench_now_ns();
+#ifdef BENCH_TSC
+	c0 = __rdtsc();
+#endif
+	for(i = 0; i < BENCH_RUNS; i++)
+	{
+		memcpy(work, tone, sizeof(work));
+		__asm__ volatile("" : : "r"(work) : "memory");
+	}
+#ifdef BENCH_TSC
+	c_copy = __rdtsc() - c0;
+#endif
+	t_copy = bench_now_ns() - t0;
+
+	t0 = bench_now_ns();
+#ifdef BENCH_TSC
+	c0 = __rdtsc();
+#endif
+	for(i = 0; i < BENCH_RUNS; i++)
+	{
+		memcpy(work, tone, sizeof(work));
+		fft_run(work, BENCH_BITS, window);
+	}
+#ifdef BENCH_TSC
+	c_run = __rdtsc() - c0;
+#endif
+	t_run = bench_now_ns() - t0;
+
+	bin = fft_peak_bin(work);
+	printf("%-4s %8.2f us/fft", name, (t_run - t_copy) / BENCH_RUNS / 1000.0);
+#ifdef BENCH_TSC
+	printf("  %8llu tsc/fft", (c_run - c_copy) / BENCH_RUNS);
+#endif
+	printf("  peak bin %u level %u\n", bin, work[bin]);
+	(void)c0; (void)c_run; (void)c_copy;
+}
+
+int main(void)
+{
+	uint32_t i = 0;
+
+	for(i = 0; i < FFT_N; i++)
+		tone[i] = (uint16_t)(2048.0 + 1800.0 * sin(2.0 * M_PI * BENCH_BIN * i / FFT_N)
+		                     + 90.0 * sin(2.0 * M_PI * 3 * BENCH_BIN * i / FFT_N));
+
+	printf("fft_run, %d samples, %d bits, %d runs\n", FFT_N, BENCH_BITS, BENCH_RUNS);
+	bench_window(FFT_WIN_RECT, "RECT");
+	bench_window(FFT_WIN_HANN, "HANN");
+	return 0;
+}
@@ -0,0 +1,7 @@
+#ifndef MAIN_H
+#define MAIN_H
+
+/* Host stand-in for User/main.h, mid_fft only needs the fixed-width types */
+#include <stdint.h>
+
+#endif /* MAIN_H */
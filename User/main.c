@@ -11,6 +11,7 @@
 #include "hw_spi.h"
 #include "hw_tim.h"
 #include "hw_adc.h"
+#include "hw_cmp.h"
 #include "mid_timer.h"
 #include "mid_pwm.h"
 #include "mid_adc.h"
@@ -39,17 +40,20 @@ int main(void)
 	uint16_t key_timer_value = 0;
 	uint16_t tft_timer_value = 0;
 	uint16_t adc_vref_value = 0;
-	uint8_t step_value = 0;
+	uint8_t timebase = 0;
 	uint8_t osc_stop_bit = 0;
 
   systick_config();		/* Clock initialization */
 
 	mx_gpio_init();			/* GPIO configuration initialization */
 	mx_spi0_init();			/* SPI0 configuration initialization */
+	mx_spi0_dma_init();		/* SPI0 transmit DMA initialization */
 	mx_adc_init();			/* ADC configuration initialization */
+	mx_cmp_init();			/* Comparator trigger initialization */
 	mx_tim2_init();			/* TIM2 configuration initialization */
 	mx_tim14_init();		/* TIM14 configuration initialization */
 	mx_tim15_init();		/* TIM15 configuration initialization */
+	mx_tim0_init();			/* TIM0 ADC sample clock initialization */
 
 	led_hanlde[led1] = led_init(LED1_GPIO_Port,LED1_Pin,RESET);	/* Register LED instance */
 	led_hanlde[led2] = led_init(LED2_GPIO_Port,LED2_Pin,RESET);	/* Register LED instance */
@@ -94,6 +98,7 @@ int main(void)
 
 	timer_enable(TIMER15);	/* Start millisecond timer */
 	timer_enable(TIMER2);		/* Start frequency measurement timer */
+	timer_enable(TIMER0);		/* Start ADC sample clock */
 	while(1)
 	{
 		key_timer_value = get_key_timer_value();
@@ -111,14 +116,21 @@ int main(void)
 			set_key_bit_value(PAUSE_MS_TIMER);
 			set_tft_bit_value(PAUSE_MS_TIMER);
 			osc_stop_bit = get_osc_stop_bit();
-			if(get_current_page() == PAGE_OSC && osc_stop_bit == OSC_RUN){
+			if(get_current_page() == PAGE_OSC && osc_stop_bit == OSC_RUN && !get_osc_roll_active()){
 				osc_waveShow(adc_vref_value);
 			}
+			else if(get_current_page() == PAGE_FFT && osc_stop_bit == OSC_RUN){
+				osc_fftShow();
+			}
 			TFT_ShowUI();
 			set_tft_timer_value(0);
 			set_key_bit_value(RUN_MS_TIMER);
 			set_tft_bit_value(RUN_MS_TIMER);
 		}
+		if(get_current_page() == PAGE_OSC && get_osc_stop_bit() == OSC_RUN && get_osc_roll_active())
+		{
+			osc_rollShow(adc_vref_value);	/* Roll: draw new columns as soon as they are sampled */
+		}
 		if(key_handle[key1].key_state != KEY_NoPress)
 		{
 			key_scanf_handle(key_handle[key1].key_pin,key_handle[key1].key_state);
@@ -141,26 +153,23 @@ int main(void)
 		}
 		if(ec11_handle.ec11_direction != ec11_static)
 		{
+			/* Forward: faster timebase, reversal: slower timebase */
+			timebase = get_adc_timebase_value();
 			if(ec11_handle.ec11_direction == ec11_forward)
 			{
-				step_value = get_step_value();
-				step_value = step_value - 1;
-				if(step_value <= 1)
+				if(timebase > 0)
 				{
-					step_value = 1;
+					timebase = timebase - 1;
 				}
-				set_step_value(step_value);
 			}
 			else
 			{
-				step_value = get_step_value();
-				step_value = step_value + 1;
-				if(step_value > 6)
+				if(timebase < ADC_TIMEBASE_NUM - 1)
 				{
-					step_value = 6;
+					timebase = timebase + 1;
 				}
-				set_step_value(step_value);
 			}
+			set_adc_timebase_value(timebase);
 			ec11_handle.ec11_direction = ec11_static;
 		}
 	}